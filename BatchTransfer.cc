@@ -0,0 +1,392 @@
+/******************************* C++ Source File *******************************
+*
+*  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+*
+*  MODULE:      system
+*
+*  DESCRIPTION: Transfer of many files as one stream.
+*
+*******************************************************************************/
+
+#include "BatchTransfer.h"
+#include "BufferPool.h"
+#include "Stat.h"
+#include "String.h"
+#include "TaskPool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+#include <endian.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+namespace
+{
+  using namespace masuma::system;
+
+  // A file being received, created by the first of its pieces to be
+  // written and closed once the last has been.
+  //
+  class OutFile
+  {
+    const std::string path;
+    const mode_t      mode;
+
+    std::once_flag created;
+    AutoFd         fd;
+
+  public:
+
+    OutFile( std::string path, mode_t mode ) : path {std::move(path)}, mode {mode} {}
+
+    void write( uint64_t offset, const uint8_t* data, size_t size )
+    {
+      std::call_once( created, [this]
+      {
+        fd = AutoFd {open, path.c_str(), O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC, mode};
+      } );
+
+      for( size_t done = 0; done < size; )
+      {
+        done += CheckSys( pwrite, ( fd.get(), data+done, size-done, offset+done ) );
+      }
+    }
+  };
+
+  // Part of a file's data in a buffer.
+  //
+  struct Piece
+  {
+    std::shared_ptr<OutFile> file;
+    uint64_t                 offset;
+    size_t                   start;
+    size_t                   length;
+  };
+
+  // Rejects names that would land outside the directory.
+  //
+  void
+  checkName( std::string_view name )
+  {
+    CheckConditionM( !name.empty() && name.front() != '/', "bad file name in batch" );
+
+    for( auto part : splitView( name, '/' ) )
+    {
+      CheckConditionM( part != "..", "bad file name in batch" );
+    }
+  }
+
+  void
+  makeDirectories( const std::string& directory, std::string_view name )
+  {
+    for( size_t slash = name.find( '/' ); slash != std::string_view::npos;
+         slash = name.find( '/', slash+1 ) )
+    {
+      const std::string path {directory+'/'+std::string {name.substr( 0, slash )}};
+
+      if( mkdir( path.c_str(), 0755 ) != 0 && errno != EEXIST )
+      {
+        throw Exception( errno, path );
+      }
+    }
+  }
+}
+
+namespace masuma::system
+{
+  size_t
+  BatchSender::readFiles( const std::string& root, const std::vector<std::string>& files )
+  {
+    size_t sent {0};
+
+    for( const auto& name : files )
+    {
+      AutoFd in;
+      Stat   status;
+
+      // Opened without blocking, so a FIFO in the list doesn't wait for a
+      // writer, and only read once it is known to be a regular file.
+      //
+      try
+      {
+        in     = AutoFd {open, (root.empty() ? name : root+'/'+name).c_str(),
+                         O_RDONLY|O_NONBLOCK|O_NOCTTY|O_CLOEXEC};
+        status = Stat {in};
+
+        if( status.isRegular() )
+        {
+          const int flags = CheckSys( fcntl, ( in.get(), F_GETFL ) );
+
+          CheckSys( fcntl, ( in.get(), F_SETFL, flags & ~O_NONBLOCK ) );
+        }
+      }
+      catch( const std::exception& e )
+      {
+        std::cerr << name << ' ' << e.what() << std::endl;
+        continue;
+      }
+
+      if( !status.isRegular() )
+      {
+        std::cerr << name << " not a regular file" << std::endl;
+        continue;
+      }
+
+      const uint64_t size = status.size();
+
+      const BatchHeader header {htobe32( name.size() ),
+                                htobe32( status.get().st_mode & 07777 ),
+                                htobe64( size )};
+
+      put( &header, sizeof header );
+      put( name.data(), name.size() );
+
+      if( uint64_t got = putFrom( in, size ); got < size )
+      {
+        std::cerr << name << " shrank while being sent" << std::endl;
+
+        static const uint8_t zeros[4096] {};
+
+        for( ; got < size; got += std::min<uint64_t>( size-got, sizeof zeros ) )
+        {
+          put( zeros, std::min<uint64_t>( size-got, sizeof zeros ) );
+        }
+      }
+
+      ++sent;
+    }
+
+    const BatchHeader end {};
+
+    put( &end, sizeof end );
+    flush();
+
+    doneWith( {nullptr,0} );
+
+    return sent;
+  }
+
+  size_t
+  BatchSender::send( AutoFd to, const std::string& root, const std::vector<std::string>& files,
+                     TransferReport* report )
+  {
+    Queue readyQueue;
+    Queue doneQueue;
+
+    const BufferPool::Lease buffers {initialiseQueue( doneQueue )};
+
+    AutoFd from;                    // Each file is opened as it is sent.
+
+    BatchSender sender {from, to, readyQueue, doneQueue, report};
+
+    std::thread sending {sender};
+
+    size_t sent {0};
+
+    try
+    {
+      sent = sender.readFiles( root, files );
+    }
+    catch( ... )
+    {
+      sender.doneWith( {nullptr,0} );
+      sending.join();
+
+      throw;
+    }
+
+    sending.join();
+
+    return sent;
+  }
+
+  // The stream is parsed from each buffer as it fills.  A header or name
+  // cut off by the end of a buffer is moved to the start of the next, so
+  // only file data is split between buffers.
+  //
+  size_t
+  BatchReceiver::receive( AutoFd from, const std::string& directory,
+                          TransferReport* report, unsigned threads )
+  {
+    using Item = FileCommon::Item;
+
+    FileCommon::Queue free;
+
+    const BufferPool::Lease buffers {BufferPool::instance().lease()};
+
+    for( auto buffer : buffers )
+    {
+      free.post( Item {buffer,0} );
+    }
+
+    const size_t chunkSize = BufferPool::instance().chunkSize();
+
+    TaskPool workers {std::max( threads, 1u )};
+
+    Item   chunk;
+    size_t filled {0};
+    size_t parsed {0};
+
+    std::vector<Piece> pieces;
+
+    free.pend( chunk );
+
+    // Hands the pieces in this buffer to a worker, and carries what hasn't
+    // been parsed over to the next.
+    //
+    auto nextBuffer = [&]
+    {
+      if( !pieces.empty() )
+      {
+        workers.post( [&free, buffer = chunk.first, pieces = std::move(pieces)]
+        {
+          try
+          {
+            for( const auto& piece : pieces )
+            {
+              piece.file->write( piece.offset, buffer+piece.start, piece.length );
+            }
+          }
+          catch( ... )
+          {
+            free.post( Item {buffer,0} );
+            throw;
+          }
+
+          free.post( Item {buffer,0} );
+        } );
+
+        pieces.clear();
+
+        const uint8_t* rest = chunk.first+parsed;
+
+        free.pend( chunk );
+
+        memmove( chunk.first, rest, filled-parsed );
+      }
+      else
+      {
+        memmove( chunk.first, chunk.first+parsed, filled-parsed );
+      }
+
+      filled -= parsed;
+      parsed  = 0;
+    };
+
+    std::shared_ptr<OutFile> file;
+    uint64_t                 offset    {0};
+    uint64_t                 remaining {0};
+
+    std::string lastDirectory;
+    size_t      received {0};
+
+    while( true )
+    {
+      const size_t available = filled-parsed;
+
+      if( file )
+      {
+        if( available )
+        {
+          const size_t n = std::min<uint64_t>( remaining, available );
+
+          pieces.push_back( {file, offset, parsed, n} );
+
+          offset    += n;
+          parsed    += n;
+          remaining -= n;
+
+          if( remaining == 0 )
+          {
+            file.reset();
+          }
+
+          continue;
+        }
+      }
+      else if( available >= sizeof(BatchHeader) )
+      {
+        BatchHeader header;
+
+        memcpy( &header, chunk.first+parsed, sizeof header );
+
+        const uint32_t nameLength = be32toh( header.nameLength );
+
+        if( nameLength == 0 )
+        {
+          break;
+        }
+
+        CheckConditionM( sizeof header+nameLength <= chunkSize, "file name too long in batch" );
+
+        if( available >= sizeof header+nameLength )
+        {
+          const std::string_view name {reinterpret_cast<const char*>(chunk.first)+parsed+sizeof header,
+                                       nameLength};
+
+          checkName( name );
+
+          if( const auto slash = name.rfind( '/' );
+              slash != std::string_view::npos && name.substr( 0, slash ) != lastDirectory )
+          {
+            makeDirectories( directory, name );
+
+            lastDirectory = name.substr( 0, slash );
+          }
+
+          file = std::make_shared<OutFile>( directory+'/'+std::string {name},
+                                            be32toh( header.mode ) );
+
+          offset    = 0;
+          remaining = be64toh( header.size );
+
+          parsed += sizeof header+nameLength;
+
+          ++received;
+
+          if( remaining == 0 )
+          {
+            pieces.push_back( {file, 0, parsed, 0} );
+            file.reset();
+          }
+
+          continue;
+        }
+      }
+
+      // Nothing more can be parsed without reading.
+      //
+      if( filled == chunkSize )
+      {
+        nextBuffer();
+      }
+
+      ssize_t n;
+
+      {
+        TransferReport::StageTimer timer {report, TransferReport::Read};
+
+        n = from.read( chunk.first+filled, chunkSize-filled );
+      }
+
+      CheckConditionM( n > 0, "batch ended early" );
+
+      filled += n;
+
+      if( report ) (*report)( n );
+    }
+
+    parsed = filled;
+
+    nextBuffer();
+
+    workers.wait();
+
+    return received;
+  }
+}
@@ -0,0 +1,211 @@
+/******************************* C++ Source File *******************************
+*
+*  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+*
+*  MODULE:      system
+*
+*  DESCRIPTION: Process wide pool of transfer buffers.
+*
+*******************************************************************************/
+
+#include "BufferPool.h"
+#include "Exception.h"
+
+#include <unistd.h>
+#include <sys/mman.h>
+
+namespace
+{
+  const size_t pageSize     = sysconf( _SC_PAGESIZE );
+  const size_t hugePageSize = 2*1024*1024;
+
+  size_t
+  roundUp( size_t n, size_t to )
+  {
+    return (n+to-1)/to*to;
+  }
+}
+
+namespace masuma::system
+{
+  BufferPool::BufferPool()
+    : mappedSize {roundUp( current.chunkSize, pageSize )}
+  {
+  }
+
+  BufferPool::~BufferPool()
+  {
+    for( auto chunk : idle )
+    {
+      free( chunk );
+    }
+  }
+
+  BufferPool&
+  BufferPool::instance()
+  {
+    static BufferPool pool;
+
+    return pool;
+  }
+
+  // Huge page chunks are carved from a mapping one huge page larger, so
+  // that they can start on a huge page boundary.
+  //
+  uint8_t*
+  BufferPool::allocate() const
+  {
+    const size_t align = current.alignment == HugePage ? hugePageSize : pageSize;
+    const size_t size  = mappedSize+align-pageSize;
+
+    void* pm = mmap( nullptr, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0 );
+
+    if( pm == MAP_FAILED )
+    {
+      throw Exception( errno, "BufferPool" );
+    }
+
+    auto* start = static_cast<uint8_t*>(pm);
+    auto* chunk = reinterpret_cast<uint8_t*>(roundUp( reinterpret_cast<uintptr_t>(start), align ));
+
+    if( chunk > start )
+    {
+      munmap( start, chunk-start );
+    }
+
+    if( const size_t after = (start+size)-(chunk+mappedSize) )
+    {
+      munmap( chunk+mappedSize, after );
+    }
+
+    if( current.alignment == HugePage )
+    {
+      madvise( chunk, mappedSize, MADV_HUGEPAGE );
+    }
+
+    if( current.locked && mlock( chunk, mappedSize ) != 0 )
+    {
+      const int error = errno;
+
+      munmap( chunk, mappedSize );
+
+      throw Exception( error, "BufferPool mlock" );
+    }
+
+    return chunk;
+  }
+
+  void
+  BufferPool::free( uint8_t* chunk ) const
+  {
+    munmap( chunk, mappedSize );
+  }
+
+  void
+  BufferPool::release( std::vector<uint8_t*>& chunks )
+  {
+    std::lock_guard<std::mutex> lock {mutex};
+
+    idle.insert( idle.end(), chunks.begin(), chunks.end() );
+
+    leased -= chunks.size();
+
+    chunks.clear();
+  }
+
+  void
+  BufferPool::configure( const Settings& settings )
+  {
+    CheckConditionM( settings.chunkSize > 0 && settings.depth > 0, "empty buffer pool" );
+
+    std::lock_guard<std::mutex> lock {mutex};
+
+    CheckConditionM( leased == 0, "buffer pool reconfigured while in use" );
+
+    const size_t align = settings.alignment == HugePage ? hugePageSize : pageSize;
+    const size_t size  = roundUp( settings.chunkSize, align );
+
+    if( size != mappedSize || settings.alignment != current.alignment ||
+        settings.locked != current.locked )
+    {
+      for( auto chunk : idle )
+      {
+        free( chunk );
+      }
+
+      idle.clear();
+    }
+
+    current           = settings;
+    current.chunkSize = roundUp( settings.chunkSize, pageSize );
+    mappedSize        = size;
+  }
+
+  BufferPool::Settings
+  BufferPool::settings() const
+  {
+    std::lock_guard<std::mutex> lock {mutex};
+
+    return current;
+  }
+
+  size_t
+  BufferPool::chunkSize() const
+  {
+    std::lock_guard<std::mutex> lock {mutex};
+
+    return current.chunkSize;
+  }
+
+  BufferPool::Lease
+  BufferPool::lease( size_t count )
+  {
+    std::lock_guard<std::mutex> lock {mutex};
+
+    if( count == 0 )
+    {
+      count = current.depth;
+    }
+
+    std::vector<uint8_t*> chunks;
+
+    chunks.reserve( count );
+
+    try
+    {
+      while( chunks.size() < count )
+      {
+        if( idle.empty() )
+        {
+          chunks.push_back( allocate() );
+        }
+        else
+        {
+          chunks.push_back( idle.back() );
+          idle.pop_back();
+        }
+      }
+    }
+    catch( ... )
+    {
+      idle.insert( idle.end(), chunks.begin(), chunks.end() );
+
+      throw;
+    }
+
+    leased += count;
+
+    return Lease {this, std::move(chunks)};
+  }
+
+  void
+  BufferPool::reserve( size_t count )
+  {
+    std::lock_guard<std::mutex> lock {mutex};
+
+    while( idle.size() < count )
+    {
+      idle.push_back( allocate() );
+    }
+  }
+}
@@ -0,0 +1,275 @@
+/******************************* C++ Source File *******************************
+*
+*  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+*
+*  MODULE:      system
+*
+*  DESCRIPTION: CRC-32C (Castagnoli) checksum.
+*
+*******************************************************************************/
+
+#include "CRC32C.h"
+
+#include <array>
+#include <cstring>
+
+#if defined __x86_64__
+# include <nmmintrin.h>
+#endif
+
+namespace
+{
+  constexpr uint32_t polynomial {0x82f63b78};
+
+  using Table = std::array<uint32_t,256>;
+
+  // Slicing-by-8 tables for the software version.
+  //
+  constexpr auto slices = []
+  {
+    std::array<Table,8> tables {};
+
+    for( uint32_t n = 0; n < 256; ++n )
+    {
+      uint32_t crc = n;
+
+      for( int k = 0; k < 8; ++k )
+      {
+        crc = crc & 1 ? (crc >> 1) ^ polynomial : crc >> 1;
+      }
+
+      tables[0][n] = crc;
+    }
+
+    for( uint32_t n = 0; n < 256; ++n )
+    {
+      uint32_t crc = tables[0][n];
+
+      for( size_t k = 1; k < 8; ++k )
+      {
+        crc = tables[0][crc & 0xff] ^ (crc >> 8);
+        tables[k][n] = crc;
+      }
+    }
+
+    return tables;
+  }();
+
+  uint64_t
+  read64( const uint8_t* p )
+  {
+    uint64_t v;
+    memcpy( &v, p, sizeof v );
+    return v;
+  }
+
+  uint32_t
+  crc32cSoftware( uint32_t crc, const uint8_t* next, size_t size )
+  {
+    uint64_t crc0 = crc ^ 0xffffffff;
+
+    while( size && (reinterpret_cast<uintptr_t>(next) & 7) != 0 )
+    {
+      crc0 = slices[0][(crc0 ^ *next++) & 0xff] ^ (crc0 >> 8);
+      --size;
+    }
+
+    while( size >= 8 )
+    {
+      crc0 ^= read64( next );
+      crc0 = slices[7][crc0 & 0xff] ^
+             slices[6][(crc0 >> 8) & 0xff] ^
+             slices[5][(crc0 >> 16) & 0xff] ^
+             slices[4][(crc0 >> 24) & 0xff] ^
+             slices[3][(crc0 >> 32) & 0xff] ^
+             slices[2][(crc0 >> 40) & 0xff] ^
+             slices[1][(crc0 >> 48) & 0xff] ^
+             slices[0][crc0 >> 56];
+      next += 8;
+      size -= 8;
+    }
+
+    while( size )
+    {
+      crc0 = slices[0][(crc0 ^ *next++) & 0xff] ^ (crc0 >> 8);
+      --size;
+    }
+
+    return static_cast<uint32_t>(crc0) ^ 0xffffffff;
+  }
+
+#if defined __x86_64__
+  // The hardware version runs three streams in parallel to hide the latency
+  // of the crc32 instruction, then combines them by shifting the earlier CRCs
+  // over the length of the later blocks.  The shift is a linear operator in
+  // GF(2), precomputed as four byte-indexed tables per block length.
+  //
+  constexpr size_t longBlock  {8192};
+  constexpr size_t shortBlock {256};
+
+  using Matrix = std::array<uint32_t,32>;
+
+  uint32_t
+  times( const Matrix& matrix, uint32_t vector )
+  {
+    uint32_t sum {0};
+
+    for( size_t n = 0; vector; vector >>= 1, ++n )
+    {
+      if( vector & 1 ) sum ^= matrix[n];
+    }
+
+    return sum;
+  }
+
+  Matrix
+  square( const Matrix& matrix )
+  {
+    Matrix result;
+
+    for( size_t n = 0; n < 32; ++n )
+    {
+      result[n] = times( matrix, matrix[n] );
+    }
+
+    return result;
+  }
+
+  // Operator that appends length (a power of two) zero bytes to a CRC.
+  //
+  Matrix
+  zerosOperator( size_t length )
+  {
+    Matrix op;
+
+    op[0] = polynomial;
+
+    for( size_t n = 1; n < 32; ++n )
+    {
+      op[n] = 1u << (n-1);
+    }
+
+    // One zero bit to one zero byte.
+    //
+    for( int n = 0; n < 3; ++n )
+    {
+      op = square( op );
+    }
+
+    for( ; length > 1; length >>= 1 )
+    {
+      op = square( op );
+    }
+
+    return op;
+  }
+
+  struct Shift
+  {
+    std::array<Table,4> zeros;
+
+    explicit Shift( size_t length )
+    {
+      const Matrix op = zerosOperator( length );
+
+      for( uint32_t n = 0; n < 256; ++n )
+      {
+        zeros[0][n] = times( op, n );
+        zeros[1][n] = times( op, n << 8 );
+        zeros[2][n] = times( op, n << 16 );
+        zeros[3][n] = times( op, n << 24 );
+      }
+    }
+
+    uint32_t operator()( uint32_t crc ) const
+    {
+      return zeros[0][crc & 0xff] ^ zeros[1][(crc >> 8) & 0xff] ^
+             zeros[2][(crc >> 16) & 0xff] ^ zeros[3][crc >> 24];
+    }
+  };
+
+  __attribute__((target("sse4.2"))) uint64_t
+  interleave( uint64_t crc0, const uint8_t*& next, size_t& size,
+              size_t block, const Shift& shift )
+  {
+    while( size >= block*3 )
+    {
+      uint64_t crc1 {0};
+      uint64_t crc2 {0};
+
+      const uint8_t* const end = next + block;
+
+      do
+      {
+        crc0 = _mm_crc32_u64( crc0, read64( next ) );
+        crc1 = _mm_crc32_u64( crc1, read64( next + block ) );
+        crc2 = _mm_crc32_u64( crc2, read64( next + block*2 ) );
+        next += 8;
+      }
+      while( next < end );
+
+      crc0 = shift( crc0 ) ^ crc1;
+      crc0 = shift( crc0 ) ^ crc2;
+
+      next += block*2;
+      size -= block*3;
+    }
+
+    return crc0;
+  }
+
+  __attribute__((target("sse4.2"))) uint32_t
+  crc32cHardware( uint32_t crc, const uint8_t* next, size_t size )
+  {
+    static const Shift longShift  {longBlock};
+    static const Shift shortShift {shortBlock};
+
+    uint64_t crc0 = crc ^ 0xffffffff;
+
+    while( size && (reinterpret_cast<uintptr_t>(next) & 7) != 0 )
+    {
+      crc0 = _mm_crc32_u8( crc0, *next++ );
+      --size;
+    }
+
+    crc0 = interleave( crc0, next, size, longBlock, longShift );
+    crc0 = interleave( crc0, next, size, shortBlock, shortShift );
+
+    while( size >= 8 )
+    {
+      crc0 = _mm_crc32_u64( crc0, read64( next ) );
+      next += 8;
+      size -= 8;
+    }
+
+    while( size )
+    {
+      crc0 = _mm_crc32_u8( crc0, *next++ );
+      --size;
+    }
+
+    return static_cast<uint32_t>(crc0) ^ 0xffffffff;
+  }
+
+#endif
+}
+
+namespace masuma::system
+{
+  uint32_t
+  crc32c( uint32_t crc, const void* buf, size_t size )
+  {
+    const auto* next = static_cast<const uint8_t*>(buf);
+
+#if defined __x86_64__
+    static const bool haveSse42 {__builtin_cpu_supports( "sse4.2" ) != 0};
+
+    if( haveSse42 )
+    {
+      return crc32cHardware( crc, next, size );
+    }
+#endif
+
+    return crc32cSoftware( crc, next, size );
+  }
+}
@@ -0,0 +1,128 @@
+/******************************* C++ Source File *******************************
+*
+*  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+*
+*  MODULE:      system
+*
+*  DESCRIPTION: Path held as a single shared buffer.
+*
+*******************************************************************************/
+
+#include "CompactPath.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace masuma::system
+{
+  CompactPath::CompactPath( std::string_view path )
+  {
+    if( path.empty() )
+    {
+      return;
+    }
+
+    // Path drops one trailing separator, so "/" is a single empty component.
+    //
+    if( path.back() == '/' )
+    {
+      path.remove_suffix( 1 );
+    }
+
+    assign( path, std::count( path.begin(), path.end(), '/' )+1 );
+  }
+
+  CompactPath::CompactPath( const Path& path )
+  {
+    std::string joined;
+
+    size_t length {0};
+
+    for( const auto& component : path )
+    {
+      length += component.size()+1;
+    }
+
+    joined.reserve( length );
+
+    for( size_t n = 0; n < path.size(); ++n )
+    {
+      if( n )
+      {
+        joined += '/';
+      }
+
+      joined += path[n];
+    }
+
+    assign( joined, path.size() );
+  }
+
+  void
+  CompactPath::assign( std::string_view joined, uint32_t components )
+  {
+    const size_t words = components+(joined.size()+sizeof(uint32_t)-1)/sizeof(uint32_t);
+
+    block  = std::make_shared_for_overwrite<uint32_t[]>( words );
+    stored = count = components;
+
+    uint32_t* offsets {block.get()};
+
+    size_t from {0};
+
+    for( uint32_t n = 0; n+1 < components; ++n )
+    {
+      from = joined.find( '/', from );
+
+      offsets[n] = from++;
+    }
+
+    if( components )
+    {
+      offsets[components-1] = joined.size();
+    }
+
+    memcpy( block.get()+components, joined.data(), joined.size() );
+  }
+
+  Path
+  CompactPath::path() const
+  {
+    Path result;
+
+    for( const auto component : *this )
+    {
+      result << std::string {component};
+    }
+
+    return result;
+  }
+
+  CompactPath
+  operator+( const CompactPath& lhs, const CompactPath& rhs )
+  {
+    if( lhs.empty() )
+    {
+      return rhs;
+    }
+
+    if( rhs.empty() )
+    {
+      return lhs;
+    }
+
+    std::string joined;
+
+    joined.reserve( lhs.view().size()+1+rhs.view().size() );
+
+    joined += lhs.view();
+    joined += '/';
+    joined += rhs.view();
+
+    CompactPath result;
+
+    result.assign( joined, lhs.size()+rhs.size() );
+
+    return result;
+  }
+}
@@ -0,0 +1,267 @@
+/******************************* C++ Source File *******************************
+*
+*  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+*
+*  MODULE:      system
+*
+*  DESCRIPTION: Vectorised delimiter search and line/field splitting.
+*
+*******************************************************************************/
+
+#include "Delimiters.h"
+
+#include <cstring>
+
+#if defined __x86_64__
+# include <immintrin.h>
+#endif
+
+namespace
+{
+  using masuma::system::DelimiterSet;
+
+  // Each kernel fills blocks words of bitmap from whole 64 byte blocks.
+  //
+  using Kernel = void (*)( const char*, size_t blocks, const DelimiterSet&, uint64_t* );
+
+  void
+  bitmapScalar( const char* data, size_t blocks, const DelimiterSet& delimiters, uint64_t* bitmap )
+  {
+    for( size_t block = 0; block < blocks; ++block, data += 64 )
+    {
+      uint64_t bits {0};
+
+      for( size_t n = 0; n < 64; ++n )
+      {
+        bits |= uint64_t {delimiters.contains( data[n] )} << n;
+      }
+
+      bitmap[block] = bits;
+    }
+  }
+
+#if defined __x86_64__
+  __attribute__((target("sse2"))) void
+  bitmapSse2( const char* data, size_t blocks, const DelimiterSet& delimiters, uint64_t* bitmap )
+  {
+    __m128i wanted[8];
+
+    for( size_t d = 0; d < delimiters.size(); ++d )
+    {
+      wanted[d] = _mm_set1_epi8( static_cast<char>(delimiters[d]) );
+    }
+
+    for( size_t block = 0; block < blocks; ++block, data += 64 )
+    {
+      uint64_t bits {0};
+
+      for( size_t lane = 0; lane < 4; ++lane )
+      {
+        const __m128i bytes = _mm_loadu_si128( reinterpret_cast<const __m128i*>(data+16*lane) );
+
+        __m128i found = _mm_cmpeq_epi8( bytes, wanted[0] );
+
+        for( size_t d = 1; d < delimiters.size(); ++d )
+        {
+          found = _mm_or_si128( found, _mm_cmpeq_epi8( bytes, wanted[d] ) );
+        }
+
+        bits |= uint64_t {static_cast<uint16_t>(_mm_movemask_epi8( found ))} << (16*lane);
+      }
+
+      bitmap[block] = bits;
+    }
+  }
+
+  __attribute__((target("avx2"))) void
+  bitmapAvx2( const char* data, size_t blocks, const DelimiterSet& delimiters, uint64_t* bitmap )
+  {
+    __m256i wanted[8];
+
+    for( size_t d = 0; d < delimiters.size(); ++d )
+    {
+      wanted[d] = _mm256_set1_epi8( static_cast<char>(delimiters[d]) );
+    }
+
+    for( size_t block = 0; block < blocks; ++block, data += 64 )
+    {
+      const __m256i low  = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(data) );
+      const __m256i high = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(data+32) );
+
+      __m256i foundLow  = _mm256_cmpeq_epi8( low, wanted[0] );
+      __m256i foundHigh = _mm256_cmpeq_epi8( high, wanted[0] );
+
+      for( size_t d = 1; d < delimiters.size(); ++d )
+      {
+        foundLow  = _mm256_or_si256( foundLow, _mm256_cmpeq_epi8( low, wanted[d] ) );
+        foundHigh = _mm256_or_si256( foundHigh, _mm256_cmpeq_epi8( high, wanted[d] ) );
+      }
+
+      bitmap[block] = uint64_t {static_cast<uint32_t>(_mm256_movemask_epi8( foundLow ))} |
+                      uint64_t {static_cast<uint32_t>(_mm256_movemask_epi8( foundHigh ))} << 32;
+    }
+  }
+#endif
+
+  Kernel
+  kernel()
+  {
+    static const Kernel k = []() -> Kernel
+    {
+#if defined __x86_64__
+      if( __builtin_cpu_supports( "avx2" ) )
+      {
+        return bitmapAvx2;
+      }
+
+      if( __builtin_cpu_supports( "sse2" ) )
+      {
+        return bitmapSse2;
+      }
+#endif
+      return bitmapScalar;
+    }();
+
+    return k;
+  }
+}
+
+namespace masuma::system
+{
+  void
+  delimiterBitmap( const char* data, size_t size, const DelimiterSet& delimiters, uint64_t* bitmap )
+  {
+    const size_t blocks = size/64;
+
+    kernel()( data, blocks, delimiters, bitmap );
+
+    // The tail is scanned from a copy so nothing past the end is read.
+    //
+    if( const size_t rest = size%64 )
+    {
+      char tail[64] {};
+
+      memcpy( tail, data+blocks*64, rest );
+
+      kernel()( tail, 1, delimiters, bitmap+blocks );
+
+      bitmap[blocks] &= (uint64_t {1} << rest)-1;
+    }
+  }
+
+  void
+  findDelimiters( const char* data, size_t size, const DelimiterSet& delimiters,
+                  std::vector<size_t>& offsets )
+  {
+    constexpr size_t chunk {4096};
+
+    uint64_t bitmap[chunk/64];
+
+    for( size_t base = 0; base < size; base += chunk )
+    {
+      const size_t length = std::min( chunk, size-base );
+
+      delimiterBitmap( data+base, length, delimiters, bitmap );
+
+      for( size_t word = 0; word < (length+63)/64; ++word )
+      {
+        for( uint64_t bits = bitmap[word]; bits; bits &= bits-1 )
+        {
+          offsets.push_back( base+word*64+std::countr_zero( bits ) );
+        }
+      }
+    }
+  }
+
+  const char*
+  findDelimiter( const char* begin, const char* end, const DelimiterSet& delimiters )
+  {
+    constexpr size_t chunk {256};
+
+    uint64_t bitmap[chunk/64];
+
+    for( const char* next = begin; next < end; next += chunk )
+    {
+      const size_t length = std::min<size_t>( chunk, end-next );
+
+      delimiterBitmap( next, length, delimiters, bitmap );
+
+      for( size_t word = 0; word < (length+63)/64; ++word )
+      {
+        if( bitmap[word] )
+        {
+          return next+word*64+std::countr_zero( bitmap[word] );
+        }
+      }
+    }
+
+    return end;
+  }
+
+  // Moves the unused data to the front, growing the buffer if a field fills
+  // it, and reads more.
+  //
+  void
+  FieldReader::fill()
+  {
+    if( begin > 0 )
+    {
+      std::copy( buffer.data()+begin, buffer.data()+end, buffer.data() );
+
+      end     -= begin;
+      scanned -= begin;
+      begin    = 0;
+    }
+
+    if( end == buffer.size() )
+    {
+      buffer.resize( buffer.size()*2 );
+    }
+
+    const std::streamsize n = in.sgetn( buffer.data()+end, buffer.size()-end );
+
+    if( n <= 0 )
+    {
+      eof = true;
+    }
+    else
+    {
+      end += n;
+    }
+  }
+
+  bool
+  FieldReader::next( std::string_view& field )
+  {
+    while( true )
+    {
+      const char* data  = buffer.data();
+      const char* found = findDelimiter( data+scanned, data+end, delimiters );
+
+      if( found != data+end )
+      {
+        field = {data+begin, static_cast<size_t>(found-data)-begin};
+        begin = scanned = found-data+1;
+
+        return true;
+      }
+
+      scanned = end;
+
+      if( eof )
+      {
+        if( begin == end )
+        {
+          return false;
+        }
+
+        field = {data+begin, end-begin};
+        begin = end;
+
+        return true;
+      }
+
+      fill();
+    }
+  }
+}
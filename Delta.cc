@@ -0,0 +1,593 @@
+/******************************* C++ Source File *******************************
+*
+*  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+*
+*  MODULE:      system
+*
+*  DESCRIPTION: Rsync style delta transfer of a changed file.
+*
+*******************************************************************************/
+
+#include "Delta.h"
+#include "MappedFile.h"
+#include "Stat.h"
+
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+
+#include <endian.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+  using namespace masuma::system;
+
+  constexpr uint32_t noBlock {~uint32_t {0}};
+
+  constexpr size_t signatureHeaderSize {3*sizeof(uint64_t)};
+  constexpr size_t signatureBlockSize  {sizeof(uint32_t)+2*sizeof(uint64_t)};
+
+  void
+  writeAll( AutoFd& fd, const uint8_t* data, size_t size )
+  {
+    for( size_t written = 0; written < size; )
+    {
+      written += fd.write( data+written, size-written );
+    }
+  }
+
+  uint8_t*
+  putBig( uint8_t* out, uint64_t value )
+  {
+    value = htobe64( value );
+
+    memcpy( out, &value, sizeof value );
+
+    return out+sizeof value;
+  }
+
+  uint8_t*
+  putBig( uint8_t* out, uint32_t value )
+  {
+    value = htobe32( value );
+
+    memcpy( out, &value, sizeof value );
+
+    return out+sizeof value;
+  }
+
+  template <typename T> T
+  getBig( const uint8_t*& in )
+  {
+    T value;
+
+    memcpy( &value, in, sizeof value );
+
+    in += sizeof value;
+
+    if constexpr( sizeof value == 8 )
+    {
+      return be64toh( value );
+    }
+    else
+    {
+      return be32toh( value );
+    }
+  }
+
+  // The full blocks of a signature by rolling checksum, a cheap filter on
+  // the checksum's halves sparing most positions the lookup.  Blocks with
+  // the same checksum are chained in order.
+  //
+  class BlockIndex
+  {
+    const Signature& signature;
+
+    std::bitset<1 << 16>                   filter;
+    std::unordered_map<uint32_t,uint32_t>  heads;
+    std::vector<uint32_t>                  next;
+
+    static size_t tag( uint32_t weak ) { return (weak ^ weak >> 16) & 0xffff; }
+
+  public:
+
+    explicit BlockIndex( const Signature& signature )
+      : signature {signature}, next( signature.blocks.size(), noBlock )
+    {
+      const size_t full = signature.fileSize/std::max<uint32_t>( signature.blockSize, 1 );
+
+      heads.reserve( full );
+
+      for( size_t block = full; block-- > 0; )
+      {
+        const uint32_t weak = signature.blocks[block].weak;
+
+        filter.set( tag( weak ) );
+
+        auto [head, added] = heads.try_emplace( weak, block );
+
+        if( !added )
+        {
+          next[block] = head->second;
+          head->second = block;
+        }
+      }
+    }
+
+    // The block matching the window, preferring wanted, or noBlock.
+    //
+    uint32_t find( uint32_t weak, const uint8_t* window, uint32_t wanted ) const
+    {
+      if( !filter.test( tag( weak ) ) )
+      {
+        return noBlock;
+      }
+
+      const auto head = heads.find( weak );
+
+      if( head == heads.end() )
+      {
+        return noBlock;
+      }
+
+      const XXH3_128Sum strong {XXH3_128Sum::hash( window, signature.blockSize )};
+
+      uint32_t found {noBlock};
+
+      for( uint32_t block = head->second; block != noBlock; block = next[block] )
+      {
+        if( signature.blocks[block].strong == strong )
+        {
+          if( block == wanted )
+          {
+            return block;
+          }
+
+          if( found == noBlock )
+          {
+            found = block;
+          }
+        }
+      }
+
+      return found;
+    }
+  };
+}
+
+namespace masuma::system
+{
+  uint32_t
+  Signature::blockSizeFor( uint64_t fileSize )
+  {
+    constexpr uint32_t smallest {700};
+    constexpr uint32_t largest  {128*1024};
+
+    const auto root = static_cast<uint32_t>(std::sqrt( static_cast<double>(fileSize) )) & ~7u;
+
+    return std::clamp( root, smallest, largest );
+  }
+
+  Signature
+  Signature::of( AutoFd fd, uint32_t blockSize )
+  {
+    Signature signature;
+
+    signature.fileSize  = Stat {fd}.size();
+    signature.blockSize = blockSize ? blockSize : blockSizeFor( signature.fileSize );
+
+    if( signature.fileSize == 0 )
+    {
+      return signature;
+    }
+
+    const ReadOnlyMappedFile file {fd, signature.fileSize, {MappingHints::Sequential}};
+
+    ReadAhead ahead {file};
+
+    signature.blocks.reserve( (signature.fileSize+signature.blockSize-1)/signature.blockSize );
+
+    for( uint64_t offset = 0; offset < signature.fileSize; offset += signature.blockSize )
+    {
+      ahead( offset );
+
+      const uint8_t* block = file.begin()+offset;
+      const size_t   size  = std::min<uint64_t>( signature.blockSize, signature.fileSize-offset );
+
+      signature.blocks.push_back( {RollingChecksum {block, size}.digest(),
+                                   XXH3_128Sum::hash( block, size )} );
+    }
+
+    return signature;
+  }
+
+  Signature
+  Signature::of( const std::string& file, uint32_t blockSize )
+  {
+    return of( AutoFd {open, file.c_str(), O_RDONLY|O_CLOEXEC}, blockSize );
+  }
+
+  void
+  Signature::send( AutoFd to ) const
+  {
+    std::vector<uint8_t> buffer( signatureHeaderSize+blocks.size()*signatureBlockSize );
+
+    uint8_t* out = buffer.data();
+
+    out = putBig( out, uint64_t {blockSize} );
+    out = putBig( out, fileSize );
+    out = putBig( out, uint64_t {blocks.size()} );
+
+    for( const auto& block : blocks )
+    {
+      out = putBig( out, block.weak );
+      out = putBig( out, block.strong.bits[1] );
+      out = putBig( out, block.strong.bits[0] );
+    }
+
+    writeAll( to, buffer.data(), buffer.size() );
+  }
+
+  Signature
+  Signature::receive( AutoFd from )
+  {
+    uint8_t header[signatureHeaderSize];
+
+    FileCommon::readToBuffer( from, header, sizeof header );
+
+    const uint8_t* in = header;
+
+    Signature signature;
+
+    const auto blockSize = getBig<uint64_t>( in );
+
+    signature.fileSize = getBig<uint64_t>( in );
+
+    const auto count = getBig<uint64_t>( in );
+
+    CheckConditionM( blockSize > 0 && blockSize <= 1024*1024*1024 &&
+                     count == (signature.fileSize+blockSize-1)/blockSize, "bad signature" );
+
+    signature.blockSize = blockSize;
+
+    std::vector<uint8_t> buffer( count*signatureBlockSize );
+
+    FileCommon::readToBuffer( from, buffer.data(), buffer.size() );
+
+    signature.blocks.resize( count );
+
+    in = buffer.data();
+
+    for( auto& block : signature.blocks )
+    {
+      block.weak           = getBig<uint32_t>( in );
+      block.strong.bits[1] = getBig<uint64_t>( in );
+      block.strong.bits[0] = getBig<uint64_t>( in );
+    }
+
+    return signature;
+  }
+
+  void
+  DeltaSender::putHeader( uint64_t kind, uint64_t value, uint64_t length )
+  {
+    const DeltaHeader header {htobe64( kind ), htobe64( value ), htobe64( length )};
+
+    put( &header, sizeof header );
+  }
+
+  void
+  DeltaSender::scan( const uint8_t* data, size_t size, const Signature& signature )
+  {
+    const BlockIndex index {signature};
+
+    const size_t blockSize = signature.blockSize;
+    const size_t chunkSize = bufferSize();
+
+    size_t   literal {0};                   // Start of the unmatched data,
+    uint32_t first   {noBlock};             // and the run of matched blocks.
+    uint32_t count   {0};
+
+    auto sendRun = [&]
+    {
+      if( count )
+      {
+        putHeader( DeltaHeader::Copy, first, count );
+
+        count = 0;
+      }
+    };
+
+    auto sendLiteral = [&]( size_t end )
+    {
+      if( end > literal )
+      {
+        sendRun();
+
+        putHeader( DeltaHeader::Literal, 0, end-literal );
+        put( data+literal, end-literal );
+
+        literal = end;
+      }
+    };
+
+    auto matched = [&]( uint32_t block, size_t at )
+    {
+      sendLiteral( at );
+
+      if( count && block == first+count )
+      {
+        ++count;
+      }
+      else
+      {
+        sendRun();
+
+        first = block;
+        count = 1;
+      }
+    };
+
+    size_t position {0};
+
+    if( size >= blockSize && signature.fileSize >= blockSize )
+    {
+      RollingChecksum checksum {data, blockSize};
+
+      while( position+blockSize <= size )
+      {
+        const uint32_t block = index.find( checksum.digest(), data+position,
+                                           count ? first+count : noBlock );
+
+        if( block != noBlock )
+        {
+          matched( block, position );
+
+          position += blockSize;
+          literal   = position;
+
+          if( position+blockSize <= size )
+          {
+            checksum = RollingChecksum {data+position, blockSize};
+          }
+        }
+        else
+        {
+          if( position+blockSize < size )
+          {
+            checksum.roll( data[position], data[position+blockSize] );
+          }
+
+          // Long literals are sent as they go, so the writer isn't idle
+          // while the file differs.
+          //
+          if( ++position-literal >= chunkSize )
+          {
+            sendLiteral( position );
+          }
+        }
+      }
+    }
+
+    // The basis's short last block can only match the end of the file.
+    //
+    if( const size_t last = signature.fileSize%blockSize; last && size-literal >= last )
+    {
+      const uint8_t* tail = data+size-last;
+
+      const Signature::Block& block = signature.blocks.back();
+
+      if( RollingChecksum {tail, last}.digest() == block.weak &&
+          XXH3_128Sum::hash( tail, last ) == block.strong )
+      {
+        matched( signature.blocks.size()-1, size-last );
+
+        literal = size;
+      }
+    }
+
+    sendLiteral( size );
+    sendRun();
+  }
+
+  void
+  DeltaSender::send( AutoFd to, AutoFd from, size_t fileSize, const Signature& signature,
+                     TransferReport* report )
+  {
+    Queue readyQueue;
+    Queue doneQueue;
+
+    const BufferPool::Lease buffers {initialiseQueue( doneQueue )};
+
+    DeltaSender sender {from, to, readyQueue, doneQueue, report};
+
+    std::thread sending {sender};
+
+    try
+    {
+      if( fileSize )
+      {
+        const ReadOnlyMappedFile file {from, fileSize, {MappingHints::Sequential}};
+
+        sender.scan( file.begin(), fileSize, signature );
+      }
+
+      sender.putHeader( DeltaHeader::End, 0, fileSize );
+      sender.flush();
+    }
+    catch( ... )
+    {
+      sender.doneWith( {nullptr,0} );
+      sending.join();
+
+      throw;
+    }
+
+    sender.doneWith( {nullptr,0} );
+
+    sending.join();
+  }
+
+  void
+  DeltaSender::send( AutoFd to, const std::string& file, size_t fileSize,
+                     const Signature& signature, TransferReport* report )
+  {
+    AutoFd from {open, file.c_str(), O_RDONLY|O_CLOEXEC};
+
+    send( std::move(to), from, fileSize, signature, report );
+  }
+
+  // Passes [offset,offset+length) of the basis to the writer.
+  //
+  void
+  DeltaReceiver::readBasis( const AutoFd& basis, uint64_t offset, uint64_t length )
+  {
+    const size_t chunkSize {bufferSize()};
+
+    while( length )
+    {
+      Item item;
+
+      {
+        TransferReport::StageTimer timer {report, TransferReport::ReaderStarved};
+
+        doneQueue.pend( item );
+      }
+
+      item.second = std::min<uint64_t>( length, chunkSize );
+
+      {
+        TransferReport::StageTimer timer {report, TransferReport::Read};
+
+        for( size_t got = 0; got < item.second; )
+        {
+          const ssize_t n = CheckSys( pread, ( basis.get(), item.first+got,
+                                               item.second-got, offset+got ) );
+
+          CheckConditionM( n > 0, "basis shorter than its signature" );
+
+          got += n;
+        }
+      }
+
+      offset += item.second;
+      length -= item.second;
+
+      doneWith( item );
+    }
+  }
+
+  void
+  DeltaReceiver::readDelta( const AutoFd& basis, const Signature& signature, size_t fileSize )
+  {
+    uint64_t written {0};
+
+    while( true )
+    {
+      DeltaHeader header;
+
+      {
+        TransferReport::StageTimer timer {report, TransferReport::Read};
+
+        readToBuffer( from, reinterpret_cast<uint8_t*>(&header), sizeof header );
+      }
+
+      const uint64_t kind   = be64toh( header.kind );
+      const uint64_t value  = be64toh( header.value );
+      const uint64_t length = be64toh( header.length );
+
+      if( kind == DeltaHeader::End )
+      {
+        CheckConditionM( length == fileSize && written == fileSize, "delta size mismatch" );
+
+        break;
+      }
+
+      if( kind == DeltaHeader::Literal )
+      {
+        CheckConditionM( length <= fileSize-written, "bad delta" );
+
+        readRange( length );
+
+        written += length;
+      }
+      else
+      {
+        CheckConditionM( kind == DeltaHeader::Copy && value < signature.blocks.size() &&
+                         length <= signature.blocks.size()-value, "bad delta" );
+
+        const uint64_t offset = value*signature.blockSize;
+        const uint64_t size   = std::min( length*signature.blockSize,
+                                          signature.fileSize-offset );
+
+        CheckConditionM( size <= fileSize-written, "bad delta" );
+
+        readBasis( basis, offset, size );
+
+        written += size;
+      }
+    }
+
+    doneWith( {nullptr,0} );
+  }
+
+  void
+  DeltaReceiver::receive( AutoFd from, AutoFd basis, const Signature& signature, AutoFd to,
+                          size_t fileSize, TransferReport* report )
+  {
+    Queue readyQueue;
+    Queue doneQueue;
+
+    const BufferPool::Lease buffers {initialiseQueue( readyQueue )};
+
+    DeltaReceiver receiver {from, to, readyQueue, doneQueue, report};
+
+    std::thread receiving {receiver};
+
+    try
+    {
+      receiver.readDelta( basis, signature, fileSize );
+    }
+    catch( ... )
+    {
+      receiver.doneWith( {nullptr,0} );
+      receiving.join();
+
+      throw;
+    }
+
+    receiving.join();
+  }
+
+  void
+  DeltaReceiver::receive( AutoFd from, const std::string& file, const Signature& signature,
+                          size_t fileSize, TransferReport* report )
+  {
+    const std::string partial {file+".delta"};
+
+    AutoFd basis {open, file.c_str(), O_RDONLY|O_CLOEXEC};
+
+    {
+      AutoFd to {open, partial.c_str(), O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC,
+                 Stat {basis}.get().st_mode & 07777};
+
+      try
+      {
+        receive( std::move(from), basis, signature, to, fileSize, report );
+      }
+      catch( ... )
+      {
+        unlink( partial.c_str() );
+
+        throw;
+      }
+    }
+
+    CheckSys( rename, ( partial.c_str(), file.c_str() ) );
+  }
+}
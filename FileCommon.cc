@@ -10,30 +10,171 @@
 
 #include "FileCommon.h"
 
-#include <memory>
+#include <cstring>
 #include <utility>
 
+#include <fcntl.h>
 #include <unistd.h>
 
 namespace masuma::system
 {
-  const size_t FileCommon::bufferSize = 8*1024*1024;
-
-  uint8_t*
+  BufferPool::Lease
   FileCommon::initialiseQueue( Queue& queue )
   {
-    constexpr size_t items = 8;
-
     CheckCondition( queue.empty() );
 
-    uint8_t* buffer {new uint8_t[bufferSize*items]};
+    BufferPool::Lease buffers {BufferPool::instance().lease()};
+
+    for( auto buffer : buffers )
+    {
+      queue.post( Item {buffer,0} );
+    }
+
+    return buffers;
+  }
+
+  FileCommon::Uncached::Uncached( AutoFd file )
+    : fd {std::move(file)},
+      flags {CheckSys( fcntl, ( fd.get(), F_GETFL ) )}
+  {
+    // Carry on from wherever the descriptor has got to (a copy that has
+    // fallen back part way through, say).
+    //
+    if( const off_t at = lseek( fd.get(), 0, SEEK_CUR ); at > 0 )
+    {
+      offset = dropped = at;
+    }
+
+    direct = fcntl( fd.get(), F_SETFL, flags|O_DIRECT ) == 0;
+  }
+
+  FileCommon::Uncached::~Uncached()
+  {
+    fcntl( fd.get(), F_SETFL, flags );
+
+    if( offset > dropped )
+    {
+      sync_file_range( fd.get(), dropped, offset-dropped,
+                       SYNC_FILE_RANGE_WAIT_BEFORE|SYNC_FILE_RANGE_WRITE|SYNC_FILE_RANGE_WAIT_AFTER );
+      posix_fadvise( fd.get(), dropped, offset-dropped, POSIX_FADV_DONTNEED );
+    }
+  }
+
+  void
+  FileCommon::Uncached::read( uint8_t* buffer, size_t size )
+  {
+    if( direct && offset % alignment != 0 )
+    {
+      CheckSys( fcntl, ( fd.get(), F_SETFL, flags ) );
+
+      direct = false;
+    }
+
+    const size_t request = direct ? (size+alignment-1) & ~(alignment-1) : size;
+
+    size_t got {0};
+
+    while( got < size )
+    {
+      const auto n = fd.read( buffer+got, request-got );
+
+      CheckConditionM( n > 0, "file shorter than expected" );
+
+      got += n;
+    }
+
+    if( !direct )
+    {
+      posix_fadvise( fd.get(), offset, size, POSIX_FADV_DONTNEED );
+    }
+
+    offset += size;
+    dropped = offset;
+  }
+
+  void
+  FileCommon::Uncached::write( const uint8_t* buffer, size_t size )
+  {
+    size_t done {0};
 
-    for( size_t n = 0; n < items; ++n )
+    if( direct && offset % alignment != 0 )
+    {
+      CheckSys( fcntl, ( fd.get(), F_SETFL, flags ) );
+
+      direct = false;
+    }
+
+    if( direct )
+    {
+      const size_t whole = size & ~(alignment-1);
+
+      while( done < whole )
+      {
+        done += fd.write( buffer+done, whole-done );
+      }
+
+      offset += done;
+      dropped = offset;
+
+      if( done == size )
+      {
+        return;
+      }
+
+      CheckSys( fcntl, ( fd.get(), F_SETFL, flags ) );
+
+      direct = false;
+    }
+
+    while( done < size )
+    {
+      done += fd.write( buffer+done, size-done );
+    }
+
+    const off_t started = offset;
+
+    offset += size;
+
+    CheckSys( sync_file_range, ( fd.get(), started, offset-started, SYNC_FILE_RANGE_WRITE ) );
+
+    if( started > dropped )
+    {
+      CheckSys( sync_file_range, ( fd.get(), dropped, started-dropped,
+                                   SYNC_FILE_RANGE_WAIT_BEFORE|SYNC_FILE_RANGE_WRITE|
+                                   SYNC_FILE_RANGE_WAIT_AFTER ) );
+
+      posix_fadvise( fd.get(), dropped, started-dropped, POSIX_FADV_DONTNEED );
+
+      dropped = started;
+    }
+  }
+
+  void
+  FileCommon::Uncached::seek( off_t to, int whence )
+  {
+    if( offset > dropped )
+    {
+      CheckSys( sync_file_range, ( fd.get(), dropped, offset-dropped,
+                                   SYNC_FILE_RANGE_WAIT_BEFORE|SYNC_FILE_RANGE_WRITE|
+                                   SYNC_FILE_RANGE_WAIT_AFTER ) );
+
+      posix_fadvise( fd.get(), dropped, offset-dropped, POSIX_FADV_DONTNEED );
+    }
+
+    offset = dropped = CheckSys( lseek, ( fd.get(), to, whence ) );
+  }
+
+  void
+  FileCommon::dropFromCache( AutoFd fd, size_t size, bool written )
+  {
+    if( written )
     {
-      queue.post( Item {buffer+bufferSize*n,0} );
+      CheckSys( sync_file_range, ( fd.get(), 0, size,
+                                   SYNC_FILE_RANGE_WAIT_BEFORE|SYNC_FILE_RANGE_WRITE|
+                                   SYNC_FILE_RANGE_WAIT_AFTER ) );
     }
 
-    return buffer;
+    posix_fadvise( fd.get(), 0, size, POSIX_FADV_DONTNEED );
   }
 
   void
@@ -43,11 +184,41 @@ namespace masuma::system
     {
       Item item;
 
-      readyQueue.pend( item );
+      {
+        TransferReport::StageTimer timer {report, TransferReport::WriterStarved};
+
+        readyQueue.pend( item );
+      }
 
-      if( item.first )
+      if( !item.first && item.second )
+      {
+        // A hole, left by seeking past it.
+        //
+        if( uncachedTo )
+        {
+          uncachedTo->seek( item.second, SEEK_CUR );
+        }
+        else
+        {
+          CheckSys( lseek, ( to.get(), item.second, SEEK_CUR ) );
+        }
+      }
+      else if( item.first )
       {
-        to.write( item.first, item.second );
+        {
+          TransferReport::StageTimer timer {report, TransferReport::Write};
+
+          if( uncachedTo )
+          {
+            uncachedTo->write( item.first, item.second );
+          }
+          else
+          {
+            to.write( item.first, item.second );
+          }
+        }
+
+        if( report ) (*report)( item.second );
 
         doneQueue.post(item);
       }
@@ -67,24 +238,136 @@ namespace masuma::system
   void
   FileCommon::readFile( size_t fileSize )
   {
-    size_t toRead {fileSize};
+    readRange( fileSize );
+
+    doneWith( {nullptr,0} );
+  }
+
+  // Passes the next size bytes of from to the writer.
+  //
+  void
+  FileCommon::readRange( size_t size )
+  {
+    const size_t chunkSize {bufferSize()};
+
+    size_t toRead {size};
 
     while( toRead )
     {
       Item item;
 
-      doneQueue.pend( item );
+      {
+        TransferReport::StageTimer timer {report, TransferReport::ReaderStarved};
+
+        doneQueue.pend( item );
+      }
 
-      item.second = std::min(toRead,bufferSize);
+      item.second = std::min(toRead,chunkSize);
 
-      readToItem( from, item );
+      {
+        TransferReport::StageTimer timer {report, TransferReport::Read};
+
+        if( uncachedFrom )
+        {
+          uncachedFrom->read( item.first, item.second );
+        }
+        else
+        {
+          readToItem( from, item );
+        }
+      }
 
       toRead -= item.second;
 
       doneWith( item );
     }
+  }
 
-    doneWith( {nullptr,0} );
+  void
+  FileCommon::put( const void* data, size_t size )
+  {
+    const auto*  next      = static_cast<const uint8_t*>(data);
+    const size_t chunkSize = bufferSize();
+
+    while( size )
+    {
+      if( !pending.first )
+      {
+        TransferReport::StageTimer timer {report, TransferReport::ReaderStarved};
+
+        doneQueue.pend( pending );
+
+        pending.second = 0;
+      }
+
+      const size_t n = std::min( size, chunkSize-pending.second );
+
+      memcpy( pending.first+pending.second, next, n );
+
+      pending.second += n;
+      next           += n;
+      size           -= n;
+
+      if( pending.second == chunkSize )
+      {
+        flush();
+      }
+    }
+  }
+
+  size_t
+  FileCommon::putFrom( AutoFd in, size_t size )
+  {
+    const size_t chunkSize = bufferSize();
+
+    size_t got {0};
+
+    while( got < size )
+    {
+      if( !pending.first )
+      {
+        TransferReport::StageTimer timer {report, TransferReport::ReaderStarved};
+
+        doneQueue.pend( pending );
+
+        pending.second = 0;
+      }
+
+      ssize_t n;
+
+      {
+        TransferReport::StageTimer timer {report, TransferReport::Read};
+
+        n = in.read( pending.first+pending.second,
+                     std::min( size-got, chunkSize-pending.second ) );
+      }
+
+      if( n == 0 )
+      {
+        break;
+      }
+
+      pending.second += n;
+      got            += n;
+
+      if( pending.second == chunkSize )
+      {
+        flush();
+      }
+    }
+
+    return got;
+  }
+
+  void
+  FileCommon::flush()
+  {
+    if( pending.first )
+    {
+      doneWith( pending );
+
+      pending = {nullptr,0};
+    }
   }
 
   void
@@ -97,6 +380,8 @@ namespace masuma::system
     {
       auto n = in.read( item.first+offset, thisRead );
 
+      CheckConditionM( n > 0, "file shorter than expected" );
+
       offset   += n;
       thisRead -= n;
     }
@@ -111,14 +396,27 @@ namespace masuma::system
   }
 
   void
-  FileCommon::copyShortFile( AutoFd from, AutoFd to, size_t fileSize )
+  FileCommon::copyShortFile( AutoFd from, AutoFd to, size_t fileSize,
+                             TransferReport* report )
   {
-    std::unique_ptr<uint8_t> buffer {new uint8_t[fileSize]};
+    CheckCondition( fileSize <= bufferSize() );
 
-    Item item {buffer.get(),fileSize};
+    const BufferPool::Lease buffer {BufferPool::instance().lease( 1 )};
 
-    readToItem( std::move(from), item );
+    Item item {buffer[0],fileSize};
+
+    {
+      TransferReport::StageTimer timer {report, TransferReport::Read};
+
+      readToItem( std::move(from), item );
+    }
+
+    {
+      TransferReport::StageTimer timer {report, TransferReport::Write};
+
+      to.write( item.first, item.second );
+    }
 
-    to.write( item.first, item.second );
+    if( report ) (*report)( item.second );
   }
 }
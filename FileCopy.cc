@@ -0,0 +1,232 @@
+/******************************* C++ Source File *******************************
+*
+*  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+*
+*  MODULE:      system
+*
+*  DESCRIPTION: Copy between local files by the fastest means available.
+*
+*******************************************************************************/
+
+#include "FileCopy.h"
+#include "FileSender.h"
+#include "Stat.h"
+
+#include <algorithm>
+#include <ostream>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+
+namespace
+{
+  using namespace masuma::system;
+
+  constexpr size_t chunkSize {64*1024*1024};
+
+  // Errors meaning a method can't be used for these files, rather than that
+  // the copy failed.
+  //
+  bool
+  refused( int error )
+  {
+    return error == EXDEV || error == EINVAL || error == ENOSYS ||
+           error == EOPNOTSUPP || error == ENOTTY;
+  }
+
+  bool
+  reflink( const AutoFd& from, const AutoFd& to )
+  {
+    if( ioctl( to.get(), FICLONE, from.get() ) == 0 )
+    {
+      return true;
+    }
+
+    if( !refused( errno ) )
+    {
+      throw Exception( errno, "FICLONE" );
+    }
+
+    return false;
+  }
+
+  // These copy size bytes from the files' offsets, returning how many were
+  // copied before the method was refused.
+  //
+  size_t
+  copyRange( const AutoFd& from, const AutoFd& to, size_t size, TransferReport* report )
+  {
+    size_t copied {0};
+
+    while( copied < size )
+    {
+      ssize_t n;
+
+      {
+        TransferReport::StageTimer timer {report, TransferReport::Write};
+
+        n = copy_file_range( from.get(), nullptr, to.get(), nullptr,
+                             std::min( chunkSize, size-copied ), 0 );
+      }
+
+      if( n < 0 )
+      {
+        if( !refused( errno ) )
+        {
+          throw Exception( errno, "copy_file_range" );
+        }
+
+        break;
+      }
+
+      CheckConditionM( n > 0, "file shorter than expected" );
+
+      copied += n;
+
+      if( report ) (*report)( n );
+    }
+
+    return copied;
+  }
+
+  size_t
+  spliceCopy( const AutoFd& from, AutoFd to, size_t size, TransferReport* report )
+  {
+    int fds[2];
+
+    CheckSys( pipe2, ( fds, O_CLOEXEC ) );
+
+    AutoFd pipeOut {fds[0]};
+    AutoFd pipeIn  {fds[1]};
+
+    fcntl( pipeIn.get(), F_SETPIPE_SZ, 1024*1024 );
+
+    const size_t pipeSize = CheckSys( fcntl, ( pipeIn.get(), F_GETPIPE_SZ ) );
+
+    size_t copied {0};
+
+    while( copied < size )
+    {
+      TransferReport::StageTimer timer {report, TransferReport::Write};
+
+      const ssize_t n = splice( from.get(), nullptr, pipeIn.get(), nullptr,
+                                std::min( pipeSize, size-copied ), SPLICE_F_MOVE );
+
+      if( n < 0 )
+      {
+        if( !refused( errno ) )
+        {
+          throw Exception( errno, "splice" );
+        }
+
+        break;
+      }
+
+      CheckConditionM( n > 0, "file shorter than expected" );
+
+      for( ssize_t drained = 0; drained < n; )
+      {
+        const ssize_t m = splice( pipeOut.get(), nullptr, to.get(), nullptr,
+                                  n-drained, SPLICE_F_MOVE );
+
+        if( m < 0 )
+        {
+          if( !refused( errno ) )
+          {
+            throw Exception( errno, "splice" );
+          }
+
+          // The data has left the file, so is written from the pipe by hand.
+          //
+          std::vector<uint8_t> rest( n-drained );
+
+          FileCommon::readToBuffer( pipeOut, rest.data(), rest.size() );
+
+          for( size_t written = 0; written < rest.size(); )
+          {
+            written += to.write( rest.data()+written, rest.size()-written );
+          }
+
+          if( report ) (*report)( n );
+
+          return copied+n;
+        }
+
+        drained += m;
+      }
+
+      copied += n;
+
+      if( report ) (*report)( n );
+    }
+
+    return copied;
+  }
+}
+
+namespace masuma::system
+{
+  std::ostream&
+  operator<<( std::ostream& out, CopyMethod method )
+  {
+    switch( method )
+    {
+      case CopyMethod::Reflink:       return out << "reflink";
+      case CopyMethod::CopyFileRange: return out << "copy_file_range";
+      case CopyMethod::Splice:        return out << "splice";
+      case CopyMethod::Buffered:      return out << "buffered";
+    }
+
+    return out;
+  }
+
+  CopyMethod
+  copyFile( AutoFd from, AutoFd to, TransferReport* report, Caching caching )
+  {
+    const size_t fileSize = Stat {from}.size();
+
+    if( reflink( from, to ) )
+    {
+      if( report ) (*report)( fileSize );
+
+      return CopyMethod::Reflink;
+    }
+
+    CopyMethod method {CopyMethod::CopyFileRange};
+
+    size_t copied = copyRange( from, to, fileSize, report );
+
+    if( copied < fileSize )
+    {
+      method  = CopyMethod::Splice;
+      copied += spliceCopy( from, to, fileSize-copied, report );
+    }
+
+    if( copied < fileSize )
+    {
+      method = CopyMethod::Buffered;
+
+      FileSender::send( to, from, fileSize-copied, report, caching );
+    }
+
+    if( caching == Caching::Uncached )
+    {
+      FileCommon::dropFromCache( from, fileSize, false );
+      FileCommon::dropFromCache( to, fileSize, true );
+    }
+
+    return method;
+  }
+
+  CopyMethod
+  copyFile( const std::string& from, const std::string& to,
+            TransferReport* report, Caching caching )
+  {
+    return copyFile( AutoFd {open, from.c_str(), O_RDONLY|O_CLOEXEC},
+                     AutoFd {open, to.c_str(), O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC, 0666},
+                     report, caching );
+  }
+}
@@ -14,40 +14,163 @@
 #include <memory>
 #include <utility>
 
+#include <endian.h>
+
 #include <fcntl.h>
 #include <unistd.h>
 
 namespace masuma::system
 {
   void
-  FileReceiver::receive( AutoFd from, AutoFd to, size_t fileSize )
+  FileReceiver::receive( AutoFd from, AutoFd to, size_t fileSize,
+                         TransferReport* report, Caching caching )
   {
-    if( fileSize < bufferSize )
+    if( fileSize < bufferSize() )
     {
-      copyShortFile( from, to, fileSize );
+      copyShortFile( from, to, fileSize, report );
+
+      if( caching == Caching::Uncached )
+      {
+        dropFromCache( to, fileSize, true );
+      }
     }
     else
     {
       Queue readyQueue;
       Queue doneQueue;
 
-      std::unique_ptr<uint8_t> buffer {initialiseQueue( readyQueue )};
+      const BufferPool::Lease buffers {initialiseQueue( readyQueue )};
+
+      FileReceiver receiver {from, to, readyQueue, doneQueue, report};
 
-      FileReceiver receiver {from, to, readyQueue, doneQueue};
+      std::unique_ptr<Uncached> uncached;
+
+      if( caching == Caching::Uncached )
+      {
+        uncached = std::make_unique<Uncached>( to );
+        receiver.uncachedTo = uncached.get();
+      }
 
       std::thread receiving {receiver};
 
-      receiver.readFile( fileSize );
+      try
+      {
+        receiver.readFile( fileSize );
+      }
+      catch( ... )
+      {
+        receiver.doneWith( {nullptr,0} );
+        receiving.join();
+
+        throw;
+      }
 
       receiving.join();
     }
   }
 
   void
-  FileReceiver::receive( AutoFd from, const std::string& file, size_t fileSize )
+  FileReceiver::receive( AutoFd from, const std::string& file, size_t fileSize,
+                         TransferReport* report, Caching caching )
+  {
+    AutoFd to {open, file.c_str(), O_WRONLY|O_CREAT|O_TRUNC, S_IRWXU|S_IRWXG};
+
+    receive( std::move(from), to, fileSize, report, caching );
+  }
+
+  // Passes each extent's data to the writer, and a null item the length of
+  // each hole for it to skip.
+  //
+  void
+  FileReceiver::readExtents( size_t fileSize )
+  {
+    uint64_t position {0};
+
+    while( true )
+    {
+      ExtentHeader header;
+
+      {
+        TransferReport::StageTimer timer {report, TransferReport::Read};
+
+        readToBuffer( from, reinterpret_cast<uint8_t*>(&header), sizeof header );
+      }
+
+      const uint64_t offset = be64toh( header.offset );
+      const uint64_t length = be64toh( header.length );
+
+      CheckConditionM( offset >= position && length <= fileSize && offset <= fileSize-length,
+                       "bad extent" );
+
+      if( offset > position )
+      {
+        doneWith( {nullptr,offset-position} );
+      }
+
+      if( length == 0 )
+      {
+        break;
+      }
+
+      readRange( length );
+
+      position = offset+length;
+    }
+
+    doneWith( {nullptr,0} );
+  }
+
+  void
+  FileReceiver::receiveSparse( AutoFd from, AutoFd to, size_t fileSize,
+                               TransferReport* report, Caching caching )
+  {
+    CheckSys( ftruncate, ( to.get(), 0 ) );
+    CheckSys( lseek, ( to.get(), 0, SEEK_SET ) );
+
+    {
+      Queue readyQueue;
+      Queue doneQueue;
+
+      const BufferPool::Lease buffers {initialiseQueue( readyQueue )};
+
+      FileReceiver receiver {from, to, readyQueue, doneQueue, report};
+
+      std::unique_ptr<Uncached> uncached;
+
+      if( caching == Caching::Uncached )
+      {
+        uncached = std::make_unique<Uncached>( to );
+        receiver.uncachedTo = uncached.get();
+      }
+
+      std::thread receiving {receiver};
+
+      try
+      {
+        receiver.readExtents( fileSize );
+      }
+      catch( ... )
+      {
+        receiver.doneWith( {nullptr,0} );
+        receiving.join();
+
+        throw;
+      }
+
+      receiving.join();
+    }
+
+    // A final hole was only seeked over.
+    //
+    CheckSys( ftruncate, ( to.get(), fileSize ) );
+  }
+
+  void
+  FileReceiver::receiveSparse( AutoFd from, const std::string& file, size_t fileSize,
+                               TransferReport* report, Caching caching )
   {
     AutoFd to {open, file.c_str(), O_WRONLY|O_CREAT|O_TRUNC, S_IRWXU|S_IRWXG};
 
-    receive( std::move(from), to, fileSize );
+    receiveSparse( std::move(from), to, fileSize, report, caching );
   }
 }
@@ -14,127 +14,187 @@
 #include <memory>
 #include <iomanip>
 #include <utility>
+#include <cstring>
+
+#include <endian.h>
 
 namespace masuma::system
 {
   void
-  FileSender::send( AutoFd to, AutoFd from, size_t fileSize )
+  FileSender::send( AutoFd to, AutoFd from, size_t fileSize,
+                    TransferReport* report, Caching caching )
   {
-    if( fileSize < bufferSize )
+    if( fileSize < bufferSize() )
     {
-      copyShortFile( from, to, fileSize );
+      copyShortFile( from, to, fileSize, report );
+
+      if( caching == Caching::Uncached )
+      {
+        dropFromCache( from, fileSize, false );
+      }
     }
     else
     {
       Queue readyQueue;
       Queue doneQueue;
 
-      std::unique_ptr<uint8_t> buffer {initialiseQueue( doneQueue )};
+      const BufferPool::Lease buffers {initialiseQueue( doneQueue )};
 
-      FileSender sender {from, to, readyQueue, doneQueue};
+      FileSender sender {from, to, readyQueue, doneQueue, report};
+
+      std::unique_ptr<Uncached> uncached;
+
+      if( caching == Caching::Uncached )
+      {
+        uncached = std::make_unique<Uncached>( from );
+        sender.uncachedFrom = uncached.get();
+      }
 
       std::thread sending {sender};
 
-      sender.readFile( fileSize );
+      try
+      {
+        sender.readFile( fileSize );
+      }
+      catch( ... )
+      {
+        sender.doneWith( {nullptr,0} );
+        sending.join();
+
+        throw;
+      }
 
       sending.join();
     }
   }
 
   void
-  FileSender::send( AutoFd to, const std::string& file, size_t fileSize )
+  FileSender::send( AutoFd to, const std::string& file, size_t fileSize,
+                    TransferReport* report, Caching caching )
   {
     AutoFd from {open, file.c_str(), O_RDONLY};
 
-    send( std::move(to), from, fileSize );
+    send( std::move(to), from, fileSize, report, caching );
   }
-}
 
-#include "MD5.h"
-
-namespace masuma::system
-{
-  struct Summer
+  void
+  FileSender::postHeader( uint64_t offset, uint64_t length )
   {
-    MD5Hash sum;
+    Item item;
 
-    using Queue = FileCommon::Queue;
-    using Item  = FileCommon::Item;
+    {
+      TransferReport::StageTimer timer {report, TransferReport::ReaderStarved};
+
+      doneQueue.pend( item );
+    }
 
-    Queue& itemQueue;
-    Queue& readyQueue;
+    const ExtentHeader header {htobe64( offset ), htobe64( length )};
 
-    Summer( Queue& itemQueue, Queue& readyQueue )
-      : itemQueue {itemQueue}, readyQueue {readyQueue} {}
+    memcpy( item.first, &header, sizeof header );
 
-    Summer( const Summer& ) = default;
+    item.second = sizeof header;
 
-    void operator()()
+    doneWith( item );
+  }
+
+  // Passes each data extent, preceded by its header, to the writer.
+  //
+  void
+  FileSender::readExtents( size_t fileSize )
+  {
+    off_t next {0};
+
+    while( next < fileSize )
     {
-      Item item {nullptr,42};
+      off_t data = lseek( from.get(), next, SEEK_DATA );
+      off_t hole = fileSize;
 
-      while( item.second )
+      if( data < 0 )
       {
-        itemQueue.pend( item );
-
-        if( item.second )
+        if( errno == ENXIO )
         {
-          sum.update( item.first, item.second );
+          break;                    // A hole to the end.
         }
-        else
-        {
-          MD5Sum result;
-
-          sum.sum( result );
 
-          std::cout << result << std::endl;
+        if( errno != EINVAL )
+        {
+          throw Exception( errno, "lseek SEEK_DATA" );
         }
 
-        readyQueue.post(item);
+        data = next;                // No SEEK_DATA, so all data.
+      }
+      else if( data >= fileSize )
+      {
+        break;
+      }
+      else
+      {
+        hole = std::min<off_t>( CheckSys( lseek, ( from.get(), data, SEEK_HOLE ) ), fileSize );
       }
-    }
 
-    void post( const Item& item ) { itemQueue.post( item ); }
-  };
+      if( uncachedFrom )
+      {
+        uncachedFrom->seek( data );
+      }
+      else
+      {
+        CheckSys( lseek, ( from.get(), data, SEEK_SET ) );
+      }
 
-  Summer* SummingFileSender::summer {nullptr};
+      postHeader( data, hole-data );
 
-  void
-  SummingFileSender::doneWith( Item item )
-  {
-    summer->post( item );
+      readRange( hole-data );
+
+      next = hole;
+    }
+
+    postHeader( fileSize, 0 );
+
+    doneWith( {nullptr,0} );
   }
 
   void
-  SummingFileSender::send( AutoFd to, AutoFd from, size_t fileSize )
+  FileSender::sendSparse( AutoFd to, AutoFd from, size_t fileSize,
+                          TransferReport* report, Caching caching )
   {
     Queue readyQueue;
     Queue doneQueue;
-    Queue summerQueue;
 
-    std::unique_ptr<uint8_t> buffer {initialiseQueue( doneQueue )};
+    const BufferPool::Lease buffers {initialiseQueue( doneQueue )};
 
-    Summer sum {summerQueue, readyQueue};
+    FileSender sender {from, to, readyQueue, doneQueue, report};
 
-    summer = &sum;
+    std::unique_ptr<Uncached> uncached;
 
-    std::thread summing {sum};
-
-    SummingFileSender sender {from, to, readyQueue, doneQueue};
+    if( caching == Caching::Uncached )
+    {
+      uncached = std::make_unique<Uncached>( from );
+      sender.uncachedFrom = uncached.get();
+    }
 
     std::thread sending {sender};
 
-    sender.readFile( fileSize );
+    try
+    {
+      sender.readExtents( fileSize );
+    }
+    catch( ... )
+    {
+      sender.doneWith( {nullptr,0} );
+      sending.join();
+
+      throw;
+    }
 
     sending.join();
-    summing.join();
   }
 
   void
-  SummingFileSender::send( AutoFd to, const std::string& file, size_t fileSize )
+  FileSender::sendSparse( AutoFd to, const std::string& file, size_t fileSize,
+                          TransferReport* report, Caching caching )
   {
     AutoFd from {open, file.c_str(), O_RDONLY};
 
-    send( to, from, fileSize );
+    sendSparse( std::move(to), from, fileSize, report, caching );
   }
 }
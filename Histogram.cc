@@ -0,0 +1,193 @@
+/******************************* C++ Source File *******************************
+ *
+ *  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+ *
+ *  MODULE:      utilities
+ *
+ *  DESCRIPTION: Log-linear latency histogram.
+ *
+ ******************************************************************************/
+
+#include "Histogram.h"
+
+#include <cmath>
+#include <iostream>
+
+namespace masuma::system
+{
+  void
+  Histogram::recordShared( int64_t value )
+  {
+    const uint64_t v = clamp( value );
+
+    counts[indexOf(v)].fetch_add( 1, std::memory_order_relaxed );
+    total.fetch_add( 1, std::memory_order_relaxed );
+    sum.fetch_add( v, std::memory_order_relaxed );
+
+    uint64_t current = minimum.load(std::memory_order_relaxed);
+
+    while( v < current &&
+           !minimum.compare_exchange_weak( current, v, std::memory_order_relaxed ) );
+
+    current = maximum.load(std::memory_order_relaxed);
+
+    while( v > current &&
+           !maximum.compare_exchange_weak( current, v, std::memory_order_relaxed ) );
+  }
+
+  void
+  Histogram::reset()
+  {
+    for( auto& c : counts )
+    {
+      c.store( 0, std::memory_order_relaxed );
+    }
+
+    total.store( 0, std::memory_order_relaxed );
+    sum.store( 0, std::memory_order_relaxed );
+    minimum.store( std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed );
+    maximum.store( 0, std::memory_order_relaxed );
+  }
+
+  Histogram&
+  Histogram::operator+=( const Histogram& other )
+  {
+    for( size_t n = 0; n < bucketCount; ++n )
+    {
+      if( const auto c = other.countAt(n) )
+      {
+        bump( counts[n], c );
+      }
+    }
+
+    bump( total, other.count() );
+    bump( sum, other.sum.load(std::memory_order_relaxed) );
+
+    const uint64_t otherMin = other.minimum.load(std::memory_order_relaxed);
+
+    if( otherMin < minimum.load(std::memory_order_relaxed) )
+    {
+      minimum.store( otherMin, std::memory_order_relaxed );
+    }
+
+    if( other.max() > max() )
+    {
+      maximum.store( other.max(), std::memory_order_relaxed );
+    }
+
+    return *this;
+  }
+
+  uint64_t
+  Histogram::min() const
+  {
+    return count() ? minimum.load(std::memory_order_relaxed) : 0;
+  }
+
+  double
+  Histogram::mean() const
+  {
+    const uint64_t n = count();
+
+    return n ? double(sum.load(std::memory_order_relaxed))/n : 0.0;
+  }
+
+  uint64_t
+  Histogram::valueAtPercentile( double percentile ) const
+  {
+    const uint64_t n = count();
+
+    if( n == 0 ) return 0;
+
+    if( percentile >= 100.0 ) return max();
+
+    uint64_t target = std::ceil( percentile/100.0 * n );
+
+    if( target == 0 ) target = 1;
+
+    uint64_t seen {0};
+
+    for( size_t index = 0; index < bucketCount; ++index )
+    {
+      seen += countAt(index);
+
+      if( seen >= target )
+      {
+        return std::min( highestEquivalent(index), max() );
+      }
+    }
+
+    return max();
+  }
+
+  void
+  Histogram::print( std::ostream& out, double scale ) const
+  {
+    out << "count " << count()
+        << " min "  << min()/scale
+        << " mean " << mean()/scale
+        << " p50 "  << valueAtPercentile(50.0)/scale
+        << " p90 "  << valueAtPercentile(90.0)/scale
+        << " p99 "  << valueAtPercentile(99.0)/scale
+        << " p999 " << valueAtPercentile(99.9)/scale
+        << " max "  << max()/scale;
+  }
+
+  void
+  Histogram::csv( std::ostream& out ) const
+  {
+    out << "lower,upper,count\n";
+
+    for( size_t index = 0; index < bucketCount; ++index )
+    {
+      if( const auto c = countAt(index) )
+      {
+        out << lowestEquivalent(index) << ','
+            << highestEquivalent(index) << ','
+            << c << '\n';
+      }
+    }
+  }
+
+  std::ostream&
+  operator<<( std::ostream& out, const Histogram& histogram )
+  {
+    histogram.print( out );
+
+    return out;
+  }
+
+  Histogram&
+  HistogramGroup::add()
+  {
+    std::lock_guard<std::mutex> lock {guard};
+
+    return histograms.emplace_back();
+  }
+
+  Histogram
+  HistogramGroup::merged() const
+  {
+    Histogram result;
+
+    std::lock_guard<std::mutex> lock {guard};
+
+    for( const auto& histogram : histograms )
+    {
+      result += histogram;
+    }
+
+    return result;
+  }
+
+  void
+  HistogramGroup::reset()
+  {
+    std::lock_guard<std::mutex> lock {guard};
+
+    for( auto& histogram : histograms )
+    {
+      histogram.reset();
+    }
+  }
+}
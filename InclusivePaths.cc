@@ -28,23 +28,183 @@ namespace masuma::system
     }
   }
 
+  InclusivePaths::InclusivePaths( const InclusivePaths& other )
+  {
+    for( const auto& path : other )
+    {
+      (*this) << path;
+    }
+  }
+
   InclusivePaths&
-  InclusivePaths::operator<<( const Path& path )
+  InclusivePaths::operator=( const InclusivePaths& other )
+  {
+    if( this != &other )
+    {
+      InclusivePaths copy {other};
+
+      *this = std::move(copy);
+    }
+
+    return *this;
+  }
+
+  // The source is left empty rather than without a root.
+  //
+  InclusivePaths::InclusivePaths( InclusivePaths&& other )
+    : root {std::move(other.root)},
+      paths {std::move(other.paths)},
+      owners {std::move(other.owners)}
+  {
+    other.clear();
+  }
+
+  InclusivePaths&
+  InclusivePaths::operator=( InclusivePaths&& other )
+  {
+    if( this != &other )
+    {
+      root   = std::move(other.root);
+      paths  = std::move(other.paths);
+      owners = std::move(other.owners);
+
+      other.clear();
+    }
+
+    return *this;
+  }
+
+  InclusivePaths::Node*
+  InclusivePaths::find( const Path& path ) const
+  {
+    Node* node {root.get()};
+
+    for( const auto& component : path )
+    {
+      auto found = node->children.find( component );
+
+      if( found == node->children.end() )
+      {
+        return nullptr;
+      }
+
+      node = found->second.get();
+    }
+
+    return node;
+  }
+
+  // Moves the last path into the gap.
+  //
+  void
+  InclusivePaths::erase( size_t index )
+  {
+    owners[index]->index = npos;
+
+    if( index != paths.size()-1 )
+    {
+      paths[index]  = std::move(paths.back());
+      owners[index] = owners.back();
+
+      owners[index]->index = index;
+    }
+
+    paths.pop_back();
+    owners.pop_back();
+  }
+
+  void
+  InclusivePaths::eraseBelow( Node& node )
+  {
+    for( auto& child : node.children )
+    {
+      if( child.second->index != npos )
+      {
+        erase( child.second->index );
+      }
+
+      eraseBelow( *child.second );
+    }
+
+    node.children.clear();
+  }
+
+  // Drops the nodes along path that no longer lead to anything.
+  //
+  void
+  InclusivePaths::prune( const Path& path )
   {
-    if( std::find_if( begin(), end(), IsParentOf(path) ) == end() )
+    std::vector<Node*> trail {root.get()};
+
+    for( const auto& component : path )
     {
-      auto i = std::find_if( begin(), end(), IsChildOf( path ) );
+      auto found = trail.back()->children.find( component );
+
+      if( found == trail.back()->children.end() )
+      {
+        break;
+      }
+
+      trail.push_back( found->second.get() );
+    }
 
-      while( i != end() )
+    for( size_t n = trail.size()-1; n > 0; --n )
+    {
+      if( trail[n]->index != npos || !trail[n]->children.empty() )
       {
-        erase( i );
+        break;
+      }
+
+      trail[n-1]->children.erase( path[n-1] );
+    }
+  }
+
+  void
+  InclusivePaths::clear()
+  {
+    root = std::make_unique<Node>();
+
+    paths.clear();
+    owners.clear();
+  }
+
+  InclusivePaths&
+  InclusivePaths::operator<<( const Path& path )
+  {
+    Node* node {root.get()};
+
+    if( node->index != npos )
+    {
+      return *this;
+    }
 
-        i = std::find_if( begin(), end(), IsChildOf( path ) );
+    // Nodes are only created below the last existing one, so none is left
+    // behind when path turns out to be covered.
+    //
+    for( const auto& component : path )
+    {
+      auto& child = node->children[component];
+
+      if( !child )
+      {
+        child = std::make_unique<Node>();
       }
 
-      emplace_back( path );
+      node = child.get();
 
+      if( node->index != npos )
+      {
+        return *this;
+      }
     }
+
+    eraseBelow( *node );
+
+    node->index = paths.size();
+
+    paths.push_back( path );
+    owners.push_back( node );
+
     return *this;
   }
 
@@ -59,22 +219,54 @@ namespace masuma::system
     return *this;
   }
 
+  bool
+  InclusivePaths::includes( const Path& path ) const
+  {
+    const Node* node {root.get()};
+
+    for( const auto& component : path )
+    {
+      if( node->index != npos )
+      {
+        return true;
+      }
+
+      auto found = node->children.find( component );
+
+      if( found == node->children.end() )
+      {
+        return false;
+      }
+
+      node = found->second.get();
+    }
+
+    return node->index != npos;
+  }
+
   void
   InclusivePaths::removeChildrenOf( const Path& path )
   {
-    auto last = std::remove_if( begin(), end(), IsChildOf(path) );
-
-    erase( last, end() );
+    if( Node* node = find( path ) )
+    {
+      eraseBelow( *node );
+      prune( path );
+    }
   }
 
   void
   InclusivePaths::removePathAndChildren( const Path& path )
   {
-    auto last = std::remove_if( begin(), end(), IsSameAs(path) );
-
-    last = std::remove_if( begin(), last, IsChildOf(path) );
+    if( Node* node = find( path ) )
+    {
+      if( node->index != npos )
+      {
+        erase( node->index );
+      }
 
-    erase( last, end() );
+      eraseBelow( *node );
+      prune( path );
+    }
   }
 
   void
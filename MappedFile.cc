@@ -12,17 +12,25 @@
 #include "Stat.h"
 
 #include <sys/mman.h>
+#include <sys/syscall.h>
 #include <fcntl.h>
+#include <unistd.h>
 
+#include <linux/mempolicy.h>
+
+#include <thread>
 #include <utility>
+#include <vector>
 
 namespace
 {
   struct Deleter
   {
-    size_t& mappedSize;
+    // By value, the mapping may outlive the MappedFile that created it.
+    //
+    size_t mappedSize;
 
-    explicit Deleter( size_t& mappedSize ) : mappedSize {mappedSize} {}
+    explicit Deleter( size_t mappedSize ) : mappedSize {mappedSize} {}
 
     void operator()( uint8_t* mapping ) const
     {
@@ -31,22 +39,101 @@ namespace
   };
 }
 
+namespace
+{
+  using namespace masuma::system;
+
+  const size_t pageSize = sysconf( _SC_PAGESIZE );
+
+  // A mask of one NUMA node for mbind() and set_mempolicy().
+  //
+  class NodeMask
+  {
+    static constexpr size_t bits {sizeof(unsigned long)*8};
+
+    std::vector<unsigned long> words;
+
+  public:
+
+    explicit NodeMask( int node )
+    {
+      CheckConditionM( node >= 0, "NUMA node" );
+
+      words.resize( node/bits+1 );
+      words[node/bits] = 1UL << node%bits;
+    }
+
+    const unsigned long* data() const { return words.data(); }
+
+    // The kernel reads one bit fewer than maxnode says.
+    //
+    unsigned long maxnode() const { return words.size()*bits+1; }
+  };
+
+  // The kernel ignores a policy set with mbind() on a shared file mapping,
+  // allocating its page cache by the policy of whichever thread faults the
+  // page in.  So placing pages on a node means moving those already
+  // resident (those mapped only by this process), and faulting the rest in
+  // from a thread whose own policy is bound to it.
+  //
+  void
+  moveTo( void* pages, size_t size, int node )
+  {
+    const NodeMask mask {node};
+
+    CheckSysM( syscall, ( SYS_mbind, pages, size, MPOL_BIND, mask.data(), mask.maxnode(),
+                          MPOL_MF_MOVE ),
+               "mbind" );
+  }
+
+  void
+  faultInOn( void* pages, size_t size, int node, int prot )
+  {
+    const NodeMask mask {node};
+
+    int error {0};
+
+    std::thread faulting {[&]
+    {
+      if( syscall( SYS_set_mempolicy, MPOL_BIND, mask.data(), mask.maxnode() ) != 0 )
+      {
+        error = errno;
+        return;
+      }
+
+      // Like the other advice, a kernel without it isn't an error.
+      //
+      madvise( pages, size, (prot & PROT_WRITE) ? MADV_POPULATE_WRITE : MADV_POPULATE_READ );
+    }};
+
+    faulting.join();
+
+    if( error )
+    {
+      throw Exception( error, "set_mempolicy" );
+    }
+  }
+}
+
 namespace masuma::system
 {
-  MappedFile::MappedFile( AutoFd fd, size_t size, int prot, int flags )
+  MappedFile::MappedFile( AutoFd fd, size_t size, int prot, int flags, const MappingHints& hints )
     : fd {std::move(fd)},
-      mapping{mapFile(size,prot,flags), Deleter{mappedSize}}
+      mapping{mapFile(size,prot,flags,hints), Deleter{mappedSize}},
+      protection {prot}
   {
   }
 
-  MappedFile::MappedFile( const std::string& name, size_t size, int prot, int flags )
+  MappedFile::MappedFile( const std::string& name, size_t size, int prot, int flags,
+                          const MappingHints& hints )
     : fd {open, name.c_str(), (prot==PROT_READ) ? O_RDONLY : O_RDWR|O_CREAT|O_TRUNC, 0600 },
-      mapping{mapFile(size,prot,flags), Deleter{mappedSize}}
+      mapping{mapFile(size,prot,flags,hints), Deleter{mappedSize}},
+      protection {prot}
   {
   }
 
   uint8_t*
-  MappedFile::mapFile( size_t fileSize, int prot, int flags )
+  MappedFile::mapFile( size_t fileSize, int prot, int flags, const MappingHints& hints )
   {
     if( fileSize == 0 )
     {
@@ -57,44 +144,135 @@ namespace masuma::system
 
     mappedSize = fileSize;
 
-    if( prot == PROT_WRITE )
+    // Allocating the space up front means running out of it is an error
+    // here rather than a SIGBUS later.
+    //
+    if( prot == PROT_WRITE && fallocate( fd.get(), 0, 0, mappedSize ) != 0 )
     {
+      if( errno != EOPNOTSUPP )
+      {
+        throw MmapException( errno, "fallocate" );
+      }
+
       fd.seekSet( mappedSize-1 );
       fd.write( "\0", 1);
       fd.seekSet( 0 );
     }
 
+    // Pages placed on a node are faulted in by faultInOn().
+    //
+    if( hints.populate && hints.numaNode < 0 )
+    {
+      flags |= MAP_POPULATE;
+    }
+
     void* pm = mmap( nullptr, mappedSize, prot, flags, fd.get(), 0 );
 
     if( pm == MAP_FAILED )
       throw MmapException( errno, "" );
 
+
+    // Advice is only advice, failures are ignored.
+    //
+    if( hints.access == MappingHints::Sequential )
+    {
+      madvise( pm, mappedSize, MADV_SEQUENTIAL );
+    }
+    else if( hints.access == MappingHints::Random )
+    {
+      madvise( pm, mappedSize, MADV_RANDOM );
+    }
+
+    if( hints.hugePages )
+    {
+      madvise( pm, mappedSize, MADV_HUGEPAGE );
+    }
+
+    if( hints.willNeed )
+    {
+      madvise( pm, mappedSize, MADV_WILLNEED );
+    }
+
+    if( hints.numaNode >= 0 )
+    {
+      try
+      {
+        moveTo( pm, mappedSize, hints.numaNode );
+
+        if( hints.populate )
+        {
+          faultInOn( pm, mappedSize, hints.numaNode, prot );
+        }
+      }
+      catch( ... )
+      {
+        munmap( pm, mappedSize );
+        throw;
+      }
+    }
+
     return static_cast<uint8_t*>(pm);
   }
+
+  void
+  MappedFile::advise( size_t offset, size_t length, int advice ) const
+  {
+    if( offset >= mappedSize )
+    {
+      return;
+    }
+
+    const size_t first = offset & ~(pageSize-1);
+    const size_t last  = std::min( offset+length, mappedSize );
+
+    CheckSys( madvise, ( mapping.get()+first, last-first, advice ) );
+  }
+
+  void
+  MappedFile::prefault( size_t offset, size_t length ) const
+  {
+    try
+    {
+      advise( offset, length, (protection & PROT_WRITE) ? MADV_POPULATE_WRITE : MADV_POPULATE_READ );
+    }
+    catch( const Exception& )
+    {
+      advise( offset, length, MADV_WILLNEED );
+    }
+  }
+
+  void
+  MappedFile::bind( int node ) const
+  {
+    moveTo( mapping.get(), mappedSize, node );
+    faultInOn( mapping.get(), mappedSize, node, protection );
+  }
 }
 
 namespace masuma::system
 {
-  ReadOnlyMappedFile::ReadOnlyMappedFile( const std::string& file, size_t size )
-    : MappedFile { file, size, PROT_READ, MAP_SHARED }
+  ReadOnlyMappedFile::ReadOnlyMappedFile( const std::string& file, size_t size,
+                                          const MappingHints& hints )
+    : MappedFile { file, size, PROT_READ, MAP_SHARED, hints }
   {
   }
 
-  ReadOnlyMappedFile::ReadOnlyMappedFile( AutoFd fd, size_t size )
-    : MappedFile { std::move(fd), size, PROT_READ, MAP_SHARED }
+  ReadOnlyMappedFile::ReadOnlyMappedFile( AutoFd fd, size_t size, const MappingHints& hints )
+    : MappedFile { std::move(fd), size, PROT_READ, MAP_SHARED, hints }
   {
   }
 }
 
 namespace masuma::system
 {
-  WriteOnlyMappedFile::WriteOnlyMappedFile( const std::string& file, size_t size )
-    : MappedFile { file, size, PROT_WRITE, MAP_SHARED }
+  WriteOnlyMappedFile::WriteOnlyMappedFile( const std::string& file, size_t size,
+                                            const MappingHints& hints )
+    : MappedFile { file, size, PROT_WRITE, MAP_SHARED, hints }
   {
   }
 
-  WriteOnlyMappedFile::WriteOnlyMappedFile( AutoFd fd, size_t size )
-    : MappedFile { std::move(fd), size, PROT_WRITE, MAP_SHARED }
+  WriteOnlyMappedFile::WriteOnlyMappedFile( AutoFd fd, size_t size, const MappingHints& hints )
+    : MappedFile { std::move(fd), size, PROT_WRITE, MAP_SHARED, hints }
   {
   }
 }
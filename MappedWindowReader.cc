@@ -0,0 +1,229 @@
+/******************************* C++ Source File *******************************
+*
+*  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+*
+*  MODULE:      system
+*
+*  DESCRIPTION: Sequential reader mapping a file a window at a time.
+*
+*******************************************************************************/
+
+#include "MappedWindowReader.h"
+#include "MappedFile.h"
+#include "Stat.h"
+
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+namespace
+{
+  const size_t pageSize = sysconf( _SC_PAGESIZE );
+}
+
+namespace masuma::system
+{
+  MappedWindowReader::MappedWindowReader( const std::string& file, size_t windowSize,
+                                          bool prefetch )
+    : MappedWindowReader {AutoFd {open, file.c_str(), O_RDONLY|O_CLOEXEC}, windowSize, prefetch}
+  {
+  }
+
+  MappedWindowReader::MappedWindowReader( AutoFd fd, size_t windowSize, bool prefetch )
+    : fd {std::move(fd)},
+      fileSize {Stat {this->fd}.size()},
+      windowSize {(std::max<size_t>( windowSize, 1 )+pageSize-1)/pageSize*pageSize}
+  {
+    if( prefetch )
+    {
+      helper = std::thread {&MappedWindowReader::prefetch, this};
+    }
+  }
+
+  MappedWindowReader::~MappedWindowReader()
+  {
+    if( helper.joinable() )
+    {
+      {
+        std::lock_guard<std::mutex> lock {mutex};
+        stopping = true;
+      }
+
+      changed.notify_all();
+      helper.join();
+    }
+
+    for( const auto& window : released )
+    {
+      unmap( window );
+    }
+
+    if( prefetched )
+    {
+      unmap( *prefetched );
+    }
+
+    unmap( current );
+  }
+
+  MappedWindowReader::Window
+  MappedWindowReader::map( uint64_t offset ) const
+  {
+    Window window;
+
+    window.offset = offset;
+    window.size   = std::min<uint64_t>( windowSize, fileSize-offset );
+
+    void* pm = mmap( nullptr, window.size, PROT_READ, MAP_SHARED, fd.get(), offset );
+
+    if( pm == MAP_FAILED )
+    {
+      throw MmapException( errno, "MappedWindowReader" );
+    }
+
+    window.data = static_cast<uint8_t*>(pm);
+
+    madvise( pm, window.size, MADV_SEQUENTIAL );
+
+    return window;
+  }
+
+  void
+  MappedWindowReader::unmap( const Window& window )
+  {
+    if( window.data )
+    {
+      munmap( window.data, window.size );
+    }
+  }
+
+  // The helper maps and faults in the wanted window and unmaps those
+  // released, so that neither happens on the reader's thread.
+  //
+  void
+  MappedWindowReader::prefetch()
+  {
+    std::unique_lock<std::mutex> lock {mutex};
+
+    while( true )
+    {
+      changed.wait( lock, [this] { return stopping || wanted || !released.empty(); } );
+
+      if( stopping )
+      {
+        return;
+      }
+
+      std::vector<Window> toUnmap;
+
+      toUnmap.swap( released );
+
+      const std::optional<uint64_t> offset {wanted};
+
+      fetching = wanted;
+      wanted.reset();
+
+      lock.unlock();
+
+      for( const auto& window : toUnmap )
+      {
+        unmap( window );
+      }
+
+      std::optional<Window> window;
+
+      if( offset )
+      {
+        try
+        {
+          window = map( *offset );
+
+          if( madvise( window->data, window->size, MADV_POPULATE_READ ) != 0 )
+          {
+            madvise( window->data, window->size, MADV_WILLNEED );
+          }
+        }
+        catch( const std::exception& )
+        {
+          // The reader maps it itself, and reports the error.
+          //
+        }
+      }
+
+      lock.lock();
+
+      if( window )
+      {
+        prefetched = window;
+      }
+
+      fetching.reset();
+      changed.notify_all();
+    }
+  }
+
+  std::span<const uint8_t>
+  MappedWindowReader::next()
+  {
+    const uint64_t offset {nextOffset};
+
+    if( offset >= fileSize )
+    {
+      return {};
+    }
+
+    Window window;
+
+    if( helper.joinable() )
+    {
+      std::unique_lock<std::mutex> lock {mutex};
+
+      // Waits for a prefetch in progress rather than mapping the window
+      // twice.
+      //
+      changed.wait( lock, [this,offset] { return wanted != offset && fetching != offset; } );
+
+      if( prefetched && prefetched->offset == offset )
+      {
+        window = *prefetched;
+        prefetched.reset();
+      }
+      else if( prefetched )
+      {
+        released.push_back( *prefetched );
+        prefetched.reset();
+      }
+
+      if( current.data )
+      {
+        released.push_back( current );
+      }
+
+      if( offset+windowSize < fileSize )
+      {
+        wanted = offset+windowSize;
+      }
+
+      lock.unlock();
+      changed.notify_all();
+    }
+    else
+    {
+      unmap( current );
+    }
+
+    current = {};
+
+    if( !window.data )
+    {
+      window = map( offset );
+    }
+
+    current    = window;
+    nextOffset = offset+window.size;
+
+    return {current.data, current.size};
+  }
+}
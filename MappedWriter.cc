@@ -0,0 +1,213 @@
+/******************************* C++ Source File *******************************
+*
+*  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+*
+*  MODULE:      system
+*
+*  DESCRIPTION: Append only writer through a growing or sliding mapping.
+*
+*******************************************************************************/
+
+#include "MappedWriter.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+namespace
+{
+  const uint64_t pageSize = sysconf( _SC_PAGESIZE );
+
+  uint64_t
+  roundUp( uint64_t n, uint64_t to )
+  {
+    return (n+to-1)/to*to;
+  }
+}
+
+namespace masuma::system
+{
+  MappedWriter::MappedWriter( const std::string& file, Mode mode,
+                              size_t windowSize, size_t allocationStep )
+    : MappedWriter {AutoFd {::open, file.c_str(), O_RDWR|O_CREAT|O_TRUNC|O_CLOEXEC, 0644},
+                    mode, windowSize, allocationStep}
+  {
+  }
+
+  MappedWriter::MappedWriter( AutoFd fd, Mode mode, size_t windowSize, size_t allocationStep )
+    : fd {std::move(fd)},
+      mode {mode},
+      windowSize {roundUp( windowSize, pageSize )},
+      allocationStep {roundUp( std::max( windowSize, allocationStep ), pageSize )}
+  {
+    CheckSys( ftruncate, ( this->fd.get(), 0 ) );
+  }
+
+  MappedWriter::~MappedWriter()
+  {
+    try
+    {
+      close();
+    }
+    catch( const std::exception& e )
+    {
+      std::cerr << "MappedWriter: " << e.what() << std::endl;
+    }
+  }
+
+  void
+  MappedWriter::allocate( uint64_t end )
+  {
+    if( end <= allocated )
+    {
+      return;
+    }
+
+    const uint64_t wanted = roundUp( end, allocationStep );
+
+    if( fallocate( fd.get(), 0, allocated, wanted-allocated ) != 0 )
+    {
+      if( errno != EOPNOTSUPP )
+      {
+        throw Exception( errno, "fallocate" );
+      }
+
+      CheckSys( ftruncate, ( fd.get(), wanted ) );
+    }
+
+    allocated = wanted;
+  }
+
+  // Maps [offset,offset+size) of the file, growing the mapping in place
+  // (or moving it) when growing.
+  //
+  void
+  MappedWriter::map( uint64_t offset, size_t size )
+  {
+    allocate( offset+size );
+
+    void* pm;
+
+    if( mode == Grow && window )
+    {
+      pm = mremap( window, mapped, size, MREMAP_MAYMOVE );
+    }
+    else
+    {
+      if( window )
+      {
+        munmap( window, mapped );
+        window = nullptr;
+      }
+
+      pm = mmap( nullptr, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd.get(), offset );
+    }
+
+    if( pm == MAP_FAILED )
+    {
+      throw MmapException( errno, "MappedWriter" );
+    }
+
+    window       = static_cast<uint8_t*>(pm);
+    windowOffset = offset;
+    mapped       = size;
+  }
+
+  // Starts write back of the pages up to end once a window's worth is
+  // waiting, and waits for the batch before.
+  //
+  void
+  MappedWriter::writeBack( uint64_t end )
+  {
+    end &= ~(pageSize-1);
+
+    if( end < flushed+windowSize )
+    {
+      return;
+    }
+
+    CheckSys( sync_file_range, ( fd.get(), flushed, end-flushed, SYNC_FILE_RANGE_WRITE ) );
+
+    if( flushed > written )
+    {
+      CheckSys( sync_file_range, ( fd.get(), written, flushed-written,
+                                   SYNC_FILE_RANGE_WAIT_BEFORE|SYNC_FILE_RANGE_WRITE|
+                                   SYNC_FILE_RANGE_WAIT_AFTER ) );
+    }
+
+    written = flushed;
+    flushed = end;
+  }
+
+  uint8_t*
+  MappedWriter::reserve( size_t n )
+  {
+    CheckCondition( open );
+
+    if( length+n > windowOffset+mapped || !window )
+    {
+      if( mode == Grow )
+      {
+        map( 0, roundUp( std::max<uint64_t>( length+n, mapped+windowSize ), windowSize ) );
+      }
+      else
+      {
+        CheckConditionM( n <= windowSize, "reservation larger than the window" );
+
+        const uint64_t from = length & ~(pageSize-1);
+
+        map( from, roundUp( std::max<uint64_t>( windowSize, length-from+n ), pageSize ) );
+      }
+    }
+
+    return window+(length-windowOffset);
+  }
+
+  void
+  MappedWriter::write( const void* data, size_t size )
+  {
+    const auto* next = static_cast<const uint8_t*>(data);
+
+    while( size )
+    {
+      const size_t chunk = std::min( size, windowSize );
+
+      memcpy( reserve( chunk ), next, chunk );
+      commit( chunk );
+
+      next += chunk;
+      size -= chunk;
+    }
+  }
+
+  void
+  MappedWriter::sync()
+  {
+    CheckSys( fdatasync, ( fd.get() ) );
+
+    flushed = written = length & ~(pageSize-1);
+  }
+
+  void
+  MappedWriter::close()
+  {
+    if( !open )
+    {
+      return;
+    }
+
+    open = false;
+
+    if( window )
+    {
+      munmap( window, mapped );
+      window = nullptr;
+    }
+
+    CheckSys( ftruncate, ( fd.get(), length ) );
+  }
+}
@@ -58,11 +58,22 @@ namespace masuma::system
   {
     if( empty() ) return std::string();
 
-    std::string out = at(0);
+    size_t length = size()-1;
+
+    for( const auto& bit : *this )
+    {
+      length += bit.size();
+    }
+
+    std::string out;
+
+    out.reserve( length );
+    out += at(0);
 
     for( size_t n = 1; n < size(); ++n )
     {
-      out = out + '/' + at(n);
+      out += '/';
+      out += at(n);
     }
 
     return out;
@@ -12,6 +12,8 @@
 #include "Path.h"
 #include "InclusivePaths.h"
 
+#include <unordered_map>
+
 namespace masuma::system
 {
   void
@@ -53,26 +55,50 @@ namespace masuma::system
     return *this;
   }
 
+  // Each source path is looked up once in the targets' trie.  Excluding
+  // removes one occurrence from paths for each source path covered.
+  //
   void
   filterPaths( const Paths& source, const InclusivePaths& targets,
                Paths& paths, bool include )
   {
-    for(const auto & target : targets)
+    if( include )
+    {
+      for( const auto& path : source )
+      {
+        if( targets.includes( path ) )
+        {
+          paths << path;
+        }
+      }
+    }
+    else
     {
-      for(const auto & path : source)
+      std::unordered_map<std::string,size_t> excluded;
+
+      for( const auto& path : source )
       {
-        if( target == path || target.isParentOf( path ) )
+        if( targets.includes( path ) )
         {
-          if( include )
-          {
-            paths << path;
-          }
-          else
-          {
-            paths.erase( std::find( paths.begin(), paths.end(), path ) );
-          }
+          ++excluded[path];
         }
       }
+
+      auto last = std::remove_if( paths.begin(), paths.end(), [&excluded]( const Path& path )
+      {
+        auto found = excluded.find( path );
+
+        if( found == excluded.end() || found->second == 0 )
+        {
+          return false;
+        }
+
+        --found->second;
+
+        return true;
+      } );
+
+      paths.erase( last, paths.end() );
     }
   }
 }
@@ -0,0 +1,219 @@
+/******************************* C++ Source File *******************************
+*
+*  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+*
+*  MODULE:      system
+*
+*  DESCRIPTION: Persistent directory tree snapshot for incremental scans.
+*
+*******************************************************************************/
+
+#include "ScanSnapshot.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+namespace
+{
+  constexpr char magic[8] {'M','S','C','A','N','S','N','P'};
+
+  void
+  writeAll( int fd, const void* buf, size_t size )
+  {
+    const auto* p = static_cast<const char*>(buf);
+
+    while( size )
+    {
+      const ssize_t n = CheckSys( ::write, ( fd, p, size ) );
+
+      p    += n;
+      size -= n;
+    }
+  }
+}
+
+namespace masuma::system
+{
+  ScanSnapshot::ScanSnapshot( const std::string& file )
+  {
+    struct stat sb;
+
+    if( ::stat( file.c_str(), &sb ) != 0 || sb.st_size < sizeof(Header) )
+    {
+      return;
+    }
+
+    ReadOnlyMappedFile snapshot {file};
+
+    if( snapshot.size() < sizeof(Header) )
+    {
+      return;
+    }
+
+    Header header;
+
+    memcpy( &header, snapshot.begin(), sizeof header );
+
+    // Each count is checked against what the file could hold before they
+    // are multiplied and added, so a corrupt header can't overflow the sum.
+    //
+    const size_t available = snapshot.size()-sizeof(Header);
+
+    if( memcmp( header.magic, magic, sizeof magic ) != 0 ||
+        header.version != version ||
+        header.directoryCount > available/sizeof(DirectoryRecord) ||
+        header.childCount > available/sizeof(ChildRecord) ||
+        header.nameBytes > available ||
+        header.directoryCount*sizeof(DirectoryRecord) + header.childCount*sizeof(ChildRecord) +
+          header.nameBytes != available )
+    {
+      return;
+    }
+
+    const uint8_t* next = snapshot.begin()+sizeof(Header);
+
+    const auto* directoryRecords = reinterpret_cast<const DirectoryRecord*>(next);
+    next += header.directoryCount*sizeof(DirectoryRecord);
+
+    const auto* children = reinterpret_cast<const ChildRecord*>(next);
+    next += header.childCount*sizeof(ChildRecord);
+
+    // Every range the records give has to lie within the file.
+    //
+    for( size_t n = 0; n < header.directoryCount; ++n )
+    {
+      const DirectoryRecord& dir {directoryRecords[n]};
+
+      if( dir.firstChild > header.childCount || dir.childCount > header.childCount-dir.firstChild )
+      {
+        return;
+      }
+    }
+
+    // And a name has to be one entry in its directory, or an unchanged
+    // directory could lead the scan back to itself or out of the tree.
+    //
+    const auto* nameBytes = reinterpret_cast<const char*>(next);
+
+    for( size_t n = 0; n < header.childCount; ++n )
+    {
+      const ChildRecord& child {children[n]};
+
+      if( child.nameOffset > header.nameBytes || child.nameLength > header.nameBytes-child.nameOffset ||
+          child.type < FileType::Missing || child.type > FileType::Other )
+      {
+        return;
+      }
+
+      const std::string_view name {nameBytes+child.nameOffset, child.nameLength};
+
+      if( name.empty() || name == "." || name == ".." ||
+          name.find_first_of( std::string_view {"/\0", 2} ) != std::string_view::npos )
+      {
+        return;
+      }
+    }
+
+    directories    = directoryRecords;
+    childRecords   = children;
+    names          = nameBytes;
+    directoryCount = header.directoryCount;
+
+    mapping = snapshot;
+  }
+
+  const ScanSnapshot::DirectoryRecord*
+  ScanSnapshot::find( uint64_t device, uint64_t inode ) const
+  {
+    DirectoryRecord key {};
+
+    key.device = device;
+    key.inode  = inode;
+
+    const DirectoryRecord* end   = directories+directoryCount;
+    const DirectoryRecord* found = std::lower_bound( directories, end, key );
+
+    if( found != end && found->device == device && found->inode == inode )
+    {
+      return found;
+    }
+
+    return nullptr;
+  }
+
+  void
+  ScanSnapshot::Builder::directory( const Stat& status, bool complete )
+  {
+    DirectoryRecord record {};
+
+    record.device     = status.get().st_dev;
+    record.inode      = status.get().st_ino;
+    record.firstChild = children.size();
+
+    // An incomplete directory (one the actions didn't descend into) gets no
+    // times, so it never matches and is read in full next time.
+    //
+    if( complete )
+    {
+      record.changeTime = nanoseconds( status.changeTime() );
+      record.modifyTime = nanoseconds( status.modifyTime() );
+    }
+
+    directories.push_back( record );
+  }
+
+  void
+  ScanSnapshot::Builder::child( std::string_view name, uint64_t inode,
+                                int64_t modifyTime, uint64_t size, FileType type )
+  {
+    CheckCondition( !directories.empty() );
+
+    ChildRecord record {};
+
+    record.inode      = inode;
+    record.modifyTime = modifyTime;
+    record.size       = size;
+    record.nameOffset = names.size();
+    record.nameLength = name.size();
+    record.type       = type;
+
+    names.append( name );
+    children.push_back( record );
+
+    ++directories.back().childCount;
+  }
+
+  void
+  ScanSnapshot::Builder::write( const std::string& file )
+  {
+    std::sort( directories.begin(), directories.end() );
+
+    Header header {};
+
+    memcpy( header.magic, magic, sizeof magic );
+
+    header.version        = version;
+    header.directoryCount = directories.size();
+    header.childCount     = children.size();
+    header.nameBytes      = names.size();
+
+    const std::string temporary {file+".new"};
+
+    {
+      AutoFd fd {open, temporary.c_str(), O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC, 0644};
+
+      writeAll( fd.get(), &header, sizeof header );
+      writeAll( fd.get(), directories.data(), directories.size()*sizeof(DirectoryRecord) );
+      writeAll( fd.get(), children.data(), children.size()*sizeof(ChildRecord) );
+      writeAll( fd.get(), names.data(), names.size() );
+
+      CheckSys( fdatasync, ( fd.get() ) );
+    }
+
+    CheckSysM( rename, ( temporary.c_str(), file.c_str() ), file );
+  }
+}
@@ -14,6 +14,8 @@
 
 #include <utime.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/sysmacros.h>
 
 namespace masuma::system
 {
@@ -52,6 +54,43 @@ namespace masuma::system
     }
   }
 
+  void
+  Stat::reset( int dirfd, const char* name )
+  {
+    if( fstatat( dirfd, name, &info, AT_SYMLINK_NOFOLLOW ) != 0 )
+    {
+      throw MissingFileException( name, errno );
+    }
+  }
+
+  void
+  Stat::reset( int dirfd, const char* name, unsigned mask )
+  {
+    struct statx sx;
+
+    if( statx( dirfd, name, AT_SYMLINK_NOFOLLOW|AT_NO_AUTOMOUNT, mask, &sx ) != 0 )
+    {
+      throw MissingFileException( name, errno );
+    }
+
+    info = {};
+
+    info.st_dev     = makedev( sx.stx_dev_major, sx.stx_dev_minor );
+    info.st_rdev    = makedev( sx.stx_rdev_major, sx.stx_rdev_minor );
+    info.st_ino     = sx.stx_ino;
+    info.st_mode    = sx.stx_mode;
+    info.st_nlink   = sx.stx_nlink;
+    info.st_uid     = sx.stx_uid;
+    info.st_gid     = sx.stx_gid;
+    info.st_size    = sx.stx_size;
+    info.st_blksize = sx.stx_blksize;
+    info.st_blocks  = sx.stx_blocks;
+
+    info.st_atim = {sx.stx_atime.tv_sec, sx.stx_atime.tv_nsec};
+    info.st_mtim = {sx.stx_mtime.tv_sec, sx.stx_mtime.tv_nsec};
+    info.st_ctim = {sx.stx_ctime.tv_sec, sx.stx_ctime.tv_nsec};
+  }
+
   FileType
   Stat::fileType() const
   {
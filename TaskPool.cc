@@ -0,0 +1,194 @@
+/******************************* C++ Source File *******************************
+*
+*  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+*
+*  MODULE:      system
+*
+*  DESCRIPTION: Work stealing thread pool.
+*
+*******************************************************************************/
+
+#include "TaskPool.h"
+
+#include <algorithm>
+
+namespace
+{
+  thread_local const masuma::system::TaskPool* currentPool {nullptr};
+  thread_local unsigned                        currentWorker {0};
+}
+
+namespace masuma::system
+{
+  TaskPool::TaskPool( unsigned count )
+  {
+    count = std::max( count, 1u );
+
+    queues.resize( count );
+
+    for( unsigned n = 0; n < count; ++n )
+    {
+      threads.emplace_back( &TaskPool::run, this, n );
+    }
+  }
+
+  TaskPool::~TaskPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock {mutex};
+
+      stopping = true;
+    }
+
+    idle.notify_all();
+
+    for( auto& thread : threads )
+    {
+      thread.join();
+    }
+  }
+
+  unsigned
+  TaskPool::worker() const
+  {
+    return currentPool == this ? currentWorker : size();
+  }
+
+  void
+  TaskPool::post( Task task )
+  {
+    unsigned self = worker();
+
+    if( self == size() )
+    {
+      self = next++ % size();
+    }
+
+    ++pending;
+
+    // Counted with the push, so a worker taking the task can't decrement
+    // queued before it has been incremented.
+    //
+    {
+      Queue& queue = queues[self];
+
+      std::lock_guard<std::mutex> lock {queue.mutex};
+
+      queue.tasks.push_back( std::move(task) );
+
+      ++queued;
+    }
+
+    // Taking the lock orders the increment with a worker's check before it
+    // waits, so the notification isn't lost.
+    //
+    {
+      std::lock_guard<std::mutex> lock {mutex};
+    }
+
+    idle.notify_one();
+  }
+
+  bool
+  TaskPool::take( unsigned self, Task& task )
+  {
+    {
+      Queue& queue = queues[self];
+
+      std::lock_guard<std::mutex> lock {queue.mutex};
+
+      if( !queue.tasks.empty() )
+      {
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        --queued;
+
+        return true;
+      }
+    }
+
+    for( unsigned n = 1; n < queues.size(); ++n )
+    {
+      Queue& victim = queues[(self+n) % queues.size()];
+
+      std::lock_guard<std::mutex> lock {victim.mutex};
+
+      if( !victim.tasks.empty() )
+      {
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        --queued;
+
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  void
+  TaskPool::run( unsigned self )
+  {
+    currentPool   = this;
+    currentWorker = self;
+
+    Task task;
+
+    while( true )
+    {
+      if( take( self, task ) )
+      {
+        try
+        {
+          task();
+        }
+        catch( ... )
+        {
+          std::lock_guard<std::mutex> lock {mutex};
+
+          if( !error )
+          {
+            error = std::current_exception();
+          }
+        }
+
+        task = nullptr;
+
+        if( --pending == 0 )
+        {
+          std::lock_guard<std::mutex> lock {mutex};
+
+          done.notify_all();
+        }
+      }
+      else
+      {
+        std::unique_lock<std::mutex> lock {mutex};
+
+        idle.wait( lock, [this]{ return queued > 0 || stopping; } );
+
+        if( stopping && queued == 0 )
+        {
+          return;
+        }
+      }
+    }
+  }
+
+  void
+  TaskPool::wait()
+  {
+    std::unique_lock<std::mutex> lock {mutex};
+
+    done.wait( lock, [this]{ return pending == 0; } );
+
+    if( error )
+    {
+      std::exception_ptr first {std::move(error)};
+
+      error = nullptr;
+
+      std::rethrow_exception( first );
+    }
+  }
+}
@@ -102,8 +102,58 @@ namespace masuma::system
     }
   }
 
+  const char*
+  TransferSnapshot::bottleneck() const
+  {
+    if( writerStarved > readerStarved )
+    {
+      return "read";
+    }
+    else if( readerStarved > writerStarved )
+    {
+      return "write";
+    }
+
+    return "none";
+  }
+
+  void
+  TransferSnapshot::json( std::ostream& out ) const
+  {
+    out << std::fixed << std::setprecision( 3 )
+        << "{\"bytes\":"          << bytes
+        << ",\"elapsed\":"        << elapsed
+        << ",\"averageRate\":"    << averageRate
+        << ",\"instantRate\":"    << instantRate
+        << ",\"ewmaRate\":"       << ewmaRate
+        << ",\"readWait\":"       << readWait
+        << ",\"writeWait\":"      << writeWait
+        << ",\"readerStarved\":"  << readerStarved
+        << ",\"writerStarved\":"  << writerStarved
+        << ",\"readerStalls\":"   << readerStalls
+        << ",\"writerStalls\":"   << writerStalls
+        << ",\"bottleneck\":\""  << bottleneck() << "\"}";
+  }
+
+  void
+  TransferSnapshot::stream( std::ostream& out ) const
+  {
+    TransferBytes::ValueUnit ewma = TransferBytes(ewmaRate).valueUnit();
+
+    out << std::fixed << std::setprecision( 2 )
+        << "ewma " << ewma.first << ewma.second << "/sec"
+        << ", read " << readWait << "s, write " << writeWait << 's'
+        << ", starved reader " << readerStarved << "s (" << readerStalls << ')'
+        << " writer " << writerStarved << "s (" << writerStalls << ')'
+        << ", bottleneck " << bottleneck();
+  }
+
   uint64_t TransferReport::threshold = 1024 * 1024 * 1024;
 
+  int64_t TransferReport::stallThreshold = oneMillion;
+  int64_t TransferReport::sampleInterval = 250*oneMillion;
+  double  TransferReport::ewmaWeight     = 0.2;
+
   TransferReport::TransferReport( system::Log::Level level )
 #if defined CLOCK_HIGHRES
       : stopwatch {CLOCK_HIGHRES, true}, level {level}
@@ -111,6 +161,69 @@ namespace masuma::system
       : stopwatch {CLOCK_REALTIME, true}, level {level}
 #endif
   {
+    // Timed from construction unless start() is called again later.
+    //
+    start();
+  }
+
+  void
+  TransferReport::start()
+  {
+    stopwatch.start();
+
+    lastSample      = timeNow( CLOCK_MONOTONIC );
+    lastSampleBytes = bytesSent.load( std::memory_order_relaxed );
+  }
+
+  void
+  TransferReport::sample()
+  {
+    const int64_t now      = timeNow( CLOCK_MONOTONIC );
+    const int64_t interval = now - lastSample;
+
+    if( interval < sampleInterval )
+    {
+      return;
+    }
+
+    const uint64_t sent = bytesSent.load( std::memory_order_relaxed );
+    const double   rate = (sent - lastSampleBytes)/timeInSeconds( interval );
+
+    // The first sample seeds the average rather than decaying up from zero.
+    //
+    const double previous = ewmaRate.load( std::memory_order_relaxed );
+
+    ewmaRate.store( previous == 0 ? rate : ewmaWeight*rate + (1-ewmaWeight)*previous,
+                    std::memory_order_relaxed );
+    instantRate.store( rate, std::memory_order_relaxed );
+
+    lastSample      = now;
+    lastSampleBytes = sent;
+  }
+
+  TransferSnapshot
+  TransferReport::snapshot() const
+  {
+    TransferSnapshot snap;
+
+    auto seconds = [this]( Stage stage )
+    {
+      return timeInSeconds( stageTime[stage].load( std::memory_order_relaxed ) );
+    };
+
+    snap.bytes         = bytesSent.load( std::memory_order_relaxed );
+    snap.elapsed       = stopwatch.elapsed();
+    snap.averageRate   = snap.elapsed > 0 ? snap.bytes/snap.elapsed : 0;
+    snap.instantRate   = instantRate.load( std::memory_order_relaxed );
+    snap.ewmaRate      = ewmaRate.load( std::memory_order_relaxed );
+    snap.readWait      = seconds( Read );
+    snap.writeWait     = seconds( Write );
+    snap.readerStarved = seconds( ReaderStarved );
+    snap.writerStarved = seconds( WriterStarved );
+    snap.readerStalls  = stalls[ReaderStarved].load( std::memory_order_relaxed );
+    snap.writerStalls  = stalls[WriterStarved].load( std::memory_order_relaxed );
+
+    return snap;
   }
 
   uint64_t
@@ -123,12 +236,21 @@ namespace masuma::system
     Log(level) << TransferBytes(n) << " in " << ElapsedTime(elapsed) << ", "
                << vu.first << vu.second << "/sec" << std::endl;
 
+    const TransferSnapshot snap = snapshot();
+
+    if( snap.readWait > 0 || snap.writeWait > 0 )
+    {
+      Log(level) << snap << std::endl;
+    }
+
     return n;
   }
 
   uint64_t
   TransferReport::report()
   {
-    return report(bytesSent);
+    uint64_t n = bytesSent.load( std::memory_order_relaxed );
+
+    return report(n);
   }
 }
@@ -0,0 +1,618 @@
+/******************************* C++ Source File *******************************
+*
+*  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+*
+*  MODULE:      system
+*
+*  DESCRIPTION: XXH3 64 and 128 bit non-cryptographic hashes.
+*
+*******************************************************************************/
+
+#include "XXH3.h"
+
+#include <bit>
+#include <cstring>
+
+#if defined __x86_64__
+# include <immintrin.h>
+#endif
+
+// A port of the XXH3 reference algorithm (little endian hosts only) limited
+// to the default secret and a zero seed.
+//
+namespace
+{
+  constexpr uint64_t prime32_1 {0x9E3779B1U};
+  constexpr uint64_t prime32_2 {0x85EBCA77U};
+  constexpr uint64_t prime32_3 {0xC2B2AE3DU};
+  constexpr uint64_t prime64_1 {0x9E3779B185EBCA87ULL};
+  constexpr uint64_t prime64_2 {0xC2B2AE3D27D4EB4FULL};
+  constexpr uint64_t prime64_3 {0x165667B19E3779F9ULL};
+  constexpr uint64_t prime64_4 {0x85EBCA77C2B2AE63ULL};
+  constexpr uint64_t prime64_5 {0x27D4EB2F165667C5ULL};
+
+  constexpr size_t stripeLength    {64};
+  constexpr size_t consumeRate     {8};
+  constexpr size_t secretSize      {192};
+  constexpr size_t secretSizeMin   {136};
+  constexpr size_t midSizeMax      {240};
+  constexpr size_t mergeAccsStart  {11};
+  constexpr size_t lastAccStart    {7};
+  constexpr size_t stripesPerBlock {(secretSize - stripeLength)/consumeRate};
+  constexpr size_t bufferSize      {256};
+  constexpr size_t bufferStripes   {bufferSize/stripeLength};
+
+  alignas(64) constexpr uint8_t secret[secretSize] =
+  {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+    0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+    0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+    0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+    0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+    0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+    0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+    0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+    0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+  };
+
+  constexpr uint64_t initialAcc[8] =
+  {
+    prime32_3, prime64_1, prime64_2, prime64_3,
+    prime64_4, prime32_2, prime64_5, prime32_1
+  };
+
+  using uint128 = unsigned __int128;
+
+  uint32_t
+  read32( const uint8_t* p )
+  {
+    uint32_t v;
+    memcpy( &v, p, sizeof v );
+    return v;
+  }
+
+  uint64_t
+  read64( const uint8_t* p )
+  {
+    uint64_t v;
+    memcpy( &v, p, sizeof v );
+    return v;
+  }
+
+  uint64_t xorshift( uint64_t v, unsigned shift ) { return v ^ (v >> shift); }
+
+  uint64_t
+  avalanche( uint64_t h )
+  {
+    h = xorshift( h, 37 ) * 0x165667919E3779F9ULL;
+    return xorshift( h, 32 );
+  }
+
+  uint64_t
+  avalancheXXH64( uint64_t h )
+  {
+    h = xorshift( h, 33 ) * prime64_2;
+    h = xorshift( h, 29 ) * prime64_3;
+    return xorshift( h, 32 );
+  }
+
+  uint64_t
+  rrmxmx( uint64_t h, uint64_t length )
+  {
+    h ^= std::rotl( h, 49 ) ^ std::rotl( h, 24 );
+    h *= 0x9FB21C651E98DF25ULL;
+    h ^= (h >> 35) + length;
+    h *= 0x9FB21C651E98DF25ULL;
+    return xorshift( h, 28 );
+  }
+
+  void
+  multiply( uint64_t lhs, uint64_t rhs, uint64_t& low, uint64_t& high )
+  {
+    const uint128 product = uint128(lhs)*rhs;
+
+    low  = static_cast<uint64_t>(product);
+    high = static_cast<uint64_t>(product >> 64);
+  }
+
+  uint64_t
+  foldedMultiply( uint64_t lhs, uint64_t rhs )
+  {
+    uint64_t low, high;
+    multiply( lhs, rhs, low, high );
+    return low ^ high;
+  }
+
+  uint64_t
+  mix16( const uint8_t* input, const uint8_t* key )
+  {
+    return foldedMultiply( read64(input) ^ read64(key), read64(input+8) ^ read64(key+8) );
+  }
+
+  void
+  mix32( uint64_t acc[2], const uint8_t* input1, const uint8_t* input2, const uint8_t* key )
+  {
+    acc[0] += mix16( input1, key );
+    acc[0] ^= read64(input2) + read64(input2+8);
+    acc[1] += mix16( input2, key+16 );
+    acc[1] ^= read64(input1) + read64(input1+8);
+  }
+
+  // 64 bit, up to midSizeMax bytes.
+  //
+  uint64_t
+  short64( const uint8_t* input, size_t length )
+  {
+    if( length == 0 )
+    {
+      return avalancheXXH64( read64(secret+56) ^ read64(secret+64) );
+    }
+    else if( length <= 3 )
+    {
+      const uint32_t combined = (uint32_t(input[0]) << 16) |
+                                (uint32_t(input[length >> 1]) << 24) |
+                                uint32_t(input[length-1]) |
+                                (uint32_t(length) << 8);
+      const uint64_t flip = read32(secret) ^ read32(secret+4);
+
+      return avalancheXXH64( combined ^ flip );
+    }
+    else if( length <= 8 )
+    {
+      const uint64_t input64 = read32(input+length-4) + (uint64_t(read32(input)) << 32);
+      const uint64_t flip    = read64(secret+8) ^ read64(secret+16);
+
+      return rrmxmx( input64 ^ flip, length );
+    }
+    else if( length <= 16 )
+    {
+      const uint64_t low  = read64(input) ^ (read64(secret+24) ^ read64(secret+32));
+      const uint64_t high = read64(input+length-8) ^ (read64(secret+40) ^ read64(secret+48));
+
+      return avalanche( length + __builtin_bswap64(low) + high + foldedMultiply( low, high ) );
+    }
+    else if( length <= 128 )
+    {
+      uint64_t acc = length*prime64_1;
+
+      if( length > 32 )
+      {
+        if( length > 64 )
+        {
+          if( length > 96 )
+          {
+            acc += mix16( input+48, secret+96 );
+            acc += mix16( input+length-64, secret+112 );
+          }
+
+          acc += mix16( input+32, secret+64 );
+          acc += mix16( input+length-48, secret+80 );
+        }
+
+        acc += mix16( input+16, secret+32 );
+        acc += mix16( input+length-32, secret+48 );
+      }
+
+      acc += mix16( input, secret );
+      acc += mix16( input+length-16, secret+16 );
+
+      return avalanche( acc );
+    }
+    else
+    {
+      const size_t rounds = length/16;
+
+      uint64_t acc = length*prime64_1;
+
+      for( size_t n = 0; n < 8; ++n )
+      {
+        acc += mix16( input+16*n, secret+16*n );
+      }
+
+      acc = avalanche( acc );
+
+      for( size_t n = 8; n < rounds; ++n )
+      {
+        acc += mix16( input+16*n, secret+16*(n-8)+3 );
+      }
+
+      acc += mix16( input+length-16, secret+secretSizeMin-17 );
+
+      return avalanche( acc );
+    }
+  }
+
+  // 128 bit, up to midSizeMax bytes.
+  //
+  void
+  short128( const uint8_t* input, size_t length, uint64_t& low, uint64_t& high )
+  {
+    if( length == 0 )
+    {
+      low  = avalancheXXH64( read64(secret+64) ^ read64(secret+72) );
+      high = avalancheXXH64( read64(secret+80) ^ read64(secret+88) );
+    }
+    else if( length <= 3 )
+    {
+      const uint32_t combinedLow = (uint32_t(input[0]) << 16) |
+                                   (uint32_t(input[length >> 1]) << 24) |
+                                   uint32_t(input[length-1]) |
+                                   (uint32_t(length) << 8);
+      const uint32_t combinedHigh = std::rotl( __builtin_bswap32(combinedLow), 13 );
+
+      low  = avalancheXXH64( combinedLow ^ (uint64_t(read32(secret)) ^ read32(secret+4)) );
+      high = avalancheXXH64( combinedHigh ^ (uint64_t(read32(secret+8)) ^ read32(secret+12)) );
+    }
+    else if( length <= 8 )
+    {
+      const uint64_t input64 = read32(input) + (uint64_t(read32(input+length-4)) << 32);
+      const uint64_t keyed   = input64 ^ (read64(secret+16) ^ read64(secret+24));
+
+      multiply( keyed, prime64_1 + (length << 2), low, high );
+
+      high += low << 1;
+      low  ^= high >> 3;
+      low   = xorshift( low, 35 ) * 0x9FB21C651E98DF25ULL;
+      low   = xorshift( low, 28 );
+      high  = avalanche( high );
+    }
+    else if( length <= 16 )
+    {
+      const uint64_t flipLow  = read64(secret+32) ^ read64(secret+40);
+      const uint64_t flipHigh = read64(secret+48) ^ read64(secret+56);
+      const uint64_t inLow    = read64(input);
+      uint64_t       inHigh   = read64(input+length-8);
+
+      uint64_t mulLow, mulHigh;
+
+      multiply( inLow ^ inHigh ^ flipLow, prime64_1, mulLow, mulHigh );
+
+      mulLow  += uint64_t(length - 1) << 54;
+      inHigh  ^= flipHigh;
+      mulHigh += inHigh + uint64_t(static_cast<uint32_t>(inHigh))*(prime32_2 - 1);
+      mulLow  ^= __builtin_bswap64( mulHigh );
+
+      uint64_t resultLow, resultHigh;
+
+      multiply( mulLow, prime64_2, resultLow, resultHigh );
+
+      resultHigh += mulHigh*prime64_2;
+
+      low  = avalanche( resultLow );
+      high = avalanche( resultHigh );
+    }
+    else
+    {
+      uint64_t acc[2] {length*prime64_1, 0};
+
+      if( length <= 128 )
+      {
+        if( length > 32 )
+        {
+          if( length > 64 )
+          {
+            if( length > 96 )
+            {
+              mix32( acc, input+48, input+length-64, secret+96 );
+            }
+
+            mix32( acc, input+32, input+length-48, secret+64 );
+          }
+
+          mix32( acc, input+16, input+length-32, secret+32 );
+        }
+
+        mix32( acc, input, input+length-16, secret );
+      }
+      else
+      {
+        const size_t rounds = length/32;
+
+        for( size_t n = 0; n < 4; ++n )
+        {
+          mix32( acc, input+32*n, input+32*n+16, secret+32*n );
+        }
+
+        acc[0] = avalanche( acc[0] );
+        acc[1] = avalanche( acc[1] );
+
+        for( size_t n = 4; n < rounds; ++n )
+        {
+          mix32( acc, input+32*n, input+32*n+16, secret+3+32*(n-4) );
+        }
+
+        mix32( acc, input+length-16, input+length-32, secret+secretSizeMin-17-16 );
+      }
+
+      low  = avalanche( acc[0] + acc[1] );
+      high = 0 - avalanche( acc[0]*prime64_1 + acc[1]*prime64_4 + length*prime64_2 );
+    }
+  }
+
+  // Stripe kernels.
+  //
+  void
+  accumulateScalar( uint64_t* acc, const uint8_t* input, const uint8_t* key, size_t stripes )
+  {
+    for( size_t s = 0; s < stripes; ++s, input += stripeLength, key += consumeRate )
+    {
+      for( size_t n = 0; n < 8; ++n )
+      {
+        const uint64_t data    = read64( input+8*n );
+        const uint64_t dataKey = data ^ read64( key+8*n );
+
+        acc[n^1] += data;
+        acc[n]   += (dataKey & 0xffffffff)*(dataKey >> 32);
+      }
+    }
+  }
+
+  void
+  scrambleScalar( uint64_t* acc, const uint8_t* key )
+  {
+    for( size_t n = 0; n < 8; ++n )
+    {
+      acc[n] = (xorshift( acc[n], 47 ) ^ read64( key+8*n ))*prime32_1;
+    }
+  }
+
+#if defined __x86_64__
+  __attribute__((target("avx2"))) inline __m256i
+  accumulateLane( __m256i acc, const uint8_t* input, const uint8_t* key )
+  {
+    const __m256i data    = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(input) );
+    const __m256i dataKey = _mm256_xor_si256( data, _mm256_loadu_si256( reinterpret_cast<const __m256i*>(key) ) );
+    const __m256i product = _mm256_mul_epu32( dataKey, _mm256_srli_epi64( dataKey, 32 ) );
+    const __m256i swapped = _mm256_shuffle_epi32( data, _MM_SHUFFLE(1,0,3,2) );
+
+    return _mm256_add_epi64( product, _mm256_add_epi64( acc, swapped ) );
+  }
+
+  __attribute__((target("avx2"))) void
+  accumulateAvx2( uint64_t* acc, const uint8_t* input, const uint8_t* key, size_t stripes )
+  {
+    auto* xacc = reinterpret_cast<__m256i*>(acc);
+
+    __m256i acc0 = _mm256_load_si256( xacc );
+    __m256i acc1 = _mm256_load_si256( xacc+1 );
+
+    for( size_t s = 0; s < stripes; ++s, input += stripeLength, key += consumeRate )
+    {
+      acc0 = accumulateLane( acc0, input,    key );
+      acc1 = accumulateLane( acc1, input+32, key+32 );
+    }
+
+    _mm256_store_si256( xacc, acc0 );
+    _mm256_store_si256( xacc+1, acc1 );
+  }
+
+  __attribute__((target("avx2"))) void
+  scrambleAvx2( uint64_t* acc, const uint8_t* key )
+  {
+    auto* xacc = reinterpret_cast<__m256i*>(acc);
+
+    const __m256i prime = _mm256_set1_epi32( static_cast<int>(prime32_1) );
+
+    for( size_t n = 0; n < 2; ++n )
+    {
+      const __m256i a       = _mm256_load_si256( xacc+n );
+      const __m256i data    = _mm256_xor_si256( a, _mm256_srli_epi64( a, 47 ) );
+      const __m256i dataKey = _mm256_xor_si256( data, _mm256_loadu_si256( reinterpret_cast<const __m256i*>(key+32*n) ) );
+      const __m256i low     = _mm256_mul_epu32( dataKey, prime );
+      const __m256i high    = _mm256_mul_epu32( _mm256_srli_epi64( dataKey, 32 ), prime );
+
+      _mm256_store_si256( xacc+n, _mm256_add_epi64( low, _mm256_slli_epi64( high, 32 ) ) );
+    }
+  }
+#endif
+
+  struct Kernels
+  {
+    void (*accumulate)( uint64_t*, const uint8_t*, const uint8_t*, size_t );
+    void (*scramble)( uint64_t*, const uint8_t* );
+
+    Kernels() : accumulate {accumulateScalar}, scramble {scrambleScalar}
+    {
+#if defined __x86_64__
+      if( __builtin_cpu_supports( "avx2" ) )
+      {
+        accumulate = accumulateAvx2;
+        scramble   = scrambleAvx2;
+      }
+#endif
+    }
+  };
+
+  const Kernels&
+  kernels()
+  {
+    static const Kernels k;
+    return k;
+  }
+
+  void
+  consumeStripes( uint64_t* acc, size_t& stripesSoFar, const uint8_t* input, size_t stripes )
+  {
+    const Kernels& k = kernels();
+
+    if( stripesPerBlock - stripesSoFar <= stripes )
+    {
+      const size_t toEnd = stripesPerBlock - stripesSoFar;
+      const size_t after = stripes - toEnd;
+
+      k.accumulate( acc, input, secret + stripesSoFar*consumeRate, toEnd );
+      k.scramble( acc, secret + secretSize - stripeLength );
+      k.accumulate( acc, input + toEnd*stripeLength, secret, after );
+
+      stripesSoFar = after;
+    }
+    else
+    {
+      k.accumulate( acc, input, secret + stripesSoFar*consumeRate, stripes );
+
+      stripesSoFar += stripes;
+    }
+  }
+
+  uint64_t
+  mergeAccumulators( const uint64_t* acc, const uint8_t* key, uint64_t start )
+  {
+    uint64_t result = start;
+
+    for( size_t n = 0; n < 4; ++n )
+    {
+      result += foldedMultiply( acc[2*n] ^ read64( key+16*n ), acc[2*n+1] ^ read64( key+16*n+8 ) );
+    }
+
+    return avalanche( result );
+  }
+}
+
+namespace masuma::system
+{
+  XXH3State::XXH3State()
+  {
+    memcpy( acc, initialAcc, sizeof acc );
+  }
+
+  void
+  XXH3State::update( const void* buf, size_t size )
+  {
+    const auto* input = static_cast<const uint8_t*>(buf);
+
+    totalLength += size;
+
+    if( buffered + size <= bufferSize )
+    {
+      memcpy( buffer+buffered, input, size );
+      buffered += size;
+      return;
+    }
+
+    if( buffered )
+    {
+      const size_t fill = bufferSize - buffered;
+
+      memcpy( buffer+buffered, input, fill );
+      input += fill;
+      size  -= fill;
+
+      consumeStripes( acc, stripesSoFar, buffer, bufferStripes );
+
+      buffered = 0;
+    }
+
+    // Always keep at least one byte back so digests see a final partial (or
+    // full) stripe, with the stripe before it saved for the catch up.
+    //
+    if( size > bufferSize )
+    {
+      do
+      {
+        consumeStripes( acc, stripesSoFar, input, bufferStripes );
+        input += bufferSize;
+        size  -= bufferSize;
+      }
+      while( size > bufferSize );
+
+      memcpy( buffer+bufferSize-stripeLength, input-stripeLength, stripeLength );
+    }
+
+    memcpy( buffer, input, size );
+    buffered = size;
+  }
+
+  void
+  XXH3State::finalAccumulators( uint64_t* result ) const
+  {
+    memcpy( result, acc, sizeof acc );
+
+    const uint8_t* const lastKey = secret + secretSize - stripeLength - lastAccStart;
+
+    if( buffered >= stripeLength )
+    {
+      size_t stripes = stripesSoFar;
+
+      consumeStripes( result, stripes, buffer, (buffered-1)/stripeLength );
+
+      kernels().accumulate( result, buffer+buffered-stripeLength, lastKey, 1 );
+    }
+    else
+    {
+      uint8_t lastStripe[stripeLength];
+
+      const size_t catchup = stripeLength - buffered;
+
+      memcpy( lastStripe, buffer+bufferSize-catchup, catchup );
+      memcpy( lastStripe+catchup, buffer, buffered );
+
+      kernels().accumulate( result, lastStripe, lastKey, 1 );
+    }
+  }
+
+  uint64_t
+  XXH3State::digest64() const
+  {
+    if( totalLength <= midSizeMax )
+    {
+      return short64( buffer, totalLength );
+    }
+
+    alignas(64) uint64_t result[8];
+
+    finalAccumulators( result );
+
+    return mergeAccumulators( result, secret+mergeAccsStart, totalLength*prime64_1 );
+  }
+
+  void
+  XXH3State::digest128( uint64_t& low, uint64_t& high ) const
+  {
+    if( totalLength <= midSizeMax )
+    {
+      short128( buffer, totalLength, low, high );
+      return;
+    }
+
+    alignas(64) uint64_t result[8];
+
+    finalAccumulators( result );
+
+    low  = mergeAccumulators( result, secret+mergeAccsStart, totalLength*prime64_1 );
+    high = mergeAccumulators( result, secret+secretSize-sizeof result-mergeAccsStart,
+                              ~(totalLength*prime64_2) );
+  }
+
+  uint64_t
+  xxh3_64( const void* buf, size_t size )
+  {
+    if( size <= midSizeMax )
+    {
+      return short64( static_cast<const uint8_t*>(buf), size );
+    }
+
+    XXH3State state;
+
+    state.update( buf, size );
+
+    return state.digest64();
+  }
+
+  void
+  xxh3_128( const void* buf, size_t size, uint64_t& low, uint64_t& high )
+  {
+    if( size <= midSizeMax )
+    {
+      short128( static_cast<const uint8_t*>(buf), size, low, high );
+      return;
+    }
+
+    XXH3State state;
+
+    state.update( buf, size );
+    state.digest128( low, high );
+  }
+}
@@ -0,0 +1,107 @@
+/******************************* C++ Source File *******************************
+*
+*  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+*
+*  MODULE:      system
+*
+*  DESCRIPTION: Times the transfer digests over the same buffers.
+*
+*  Hashes buffers of random data with each of the hashes HashingFileSender
+*  can use and prints their rates, to choose one for a link:
+*
+*    HashBench [buffer MB] [buffers] [passes]
+*
+*  e.g. HashBench 4 16 8 hashes sixteen 4 MB buffers eight times.  The
+*  buffers are the size of the pool's chunks by default, and each hash is
+*  fed them a buffer per update() as it would be during a transfer.
+*
+*******************************************************************************/
+
+#include "BufferPool.h"
+#include "CRC32C.h"
+#include "MD5.h"
+#include "String.h"
+#include "XXH3.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace masuma::system;
+
+namespace
+{
+  using Buffers = std::vector<std::vector<uint8_t>>;
+
+  template <typename Hash> void
+  rate( const char* name, const Buffers& buffers, size_t passes )
+  {
+    Hash hash;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for( size_t pass = 0; pass < passes; ++pass )
+    {
+      for( const auto& buffer : buffers )
+      {
+        hash.update( buffer.data(), buffer.size() );
+      }
+    }
+
+    typename Hash::Sum result;
+
+    hash.sum( result );
+
+    const std::chrono::duration<double> elapsed {std::chrono::steady_clock::now()-start};
+
+    const double bytes = double(passes)*buffers.size()*buffers.front().size();
+
+    std::cout << std::left << std::setw(10) << name << std::right
+              << std::setw(10) << std::fixed << std::setprecision(0)
+              << bytes/elapsed.count()/(1024*1024) << " MB/s  " << result << std::endl;
+  }
+}
+
+int
+main( int argc, char** argv )
+{
+  try
+  {
+    const size_t bufferSize = argc > 1 ? fromString<size_t>( argv[1] )*1024*1024
+                                       : BufferPool::instance().chunkSize();
+    const size_t count      = argc > 2 ? fromString<size_t>( argv[2] ) : 16;
+    const size_t passes     = argc > 3 ? fromString<size_t>( argv[3] ) : 8;
+
+    if( bufferSize == 0 || count == 0 || passes == 0 )
+    {
+      std::cerr << "usage: HashBench [buffer MB] [buffers] [passes]" << std::endl;
+      return 1;
+    }
+
+    std::mt19937_64 random {42};
+
+    Buffers buffers( count, std::vector<uint8_t>( bufferSize ) );
+
+    for( auto& buffer : buffers )
+    {
+      for( auto& byte : buffer )
+      {
+        byte = static_cast<uint8_t>(random());
+      }
+    }
+
+    rate<MD5Hash>( "MD5", buffers, passes );
+    rate<CRC32CHash>( "CRC32C", buffers, passes );
+    rate<XXH3Hash>( "XXH3", buffers, passes );
+    rate<XXH3_128Hash>( "XXH3_128", buffers, passes );
+  }
+  catch( const std::exception& e )
+  {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
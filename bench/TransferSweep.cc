@@ -0,0 +1,134 @@
+/******************************* C++ Source File *******************************
+*
+*  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+*
+*  MODULE:      system
+*
+*  DESCRIPTION: Sweeps transfer buffer chunk size against depth.
+*
+*  Copies a file with FileSender for each combination of the pool's chunk
+*  size and depth and prints the rates as a table, to choose the settings
+*  for a pair of disks:
+*
+*    TransferSweep <from> <to> [chunk MB,...] [depth,...] [--cached]
+*
+*  e.g. TransferSweep /data/big /scratch/copy 1,4,16 2,8,32.  The source
+*  is read uncached so each run reads the disk, and the copy is synced
+*  before it is timed.
+*
+*******************************************************************************/
+
+#include "FileSender.h"
+#include "BufferPool.h"
+#include "Stat.h"
+#include "String.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace masuma::system;
+
+namespace
+{
+  std::vector<size_t>
+  sizes( const std::string& list )
+  {
+    std::vector<size_t> result;
+
+    for( auto value : splitView( list, ',' ) )
+    {
+      result.push_back( fromString<size_t>( std::string {value} ) );
+    }
+
+    return result;
+  }
+
+  double
+  rate( const std::string& from, const std::string& to, size_t fileSize, Caching caching )
+  {
+    const auto start = std::chrono::steady_clock::now();
+
+    AutoFd out {open, to.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644};
+
+    FileSender::send( out, from, fileSize, nullptr, caching );
+
+    CheckSys( fdatasync, ( out.get() ) );
+
+    const std::chrono::duration<double> elapsed {std::chrono::steady_clock::now()-start};
+
+    return fileSize/elapsed.count()/(1024*1024);
+  }
+}
+
+int
+main( int argc, char** argv )
+{
+  std::vector<std::string> args {argv+1, argv+argc};
+
+  Caching caching {Caching::Uncached};
+
+  std::erase_if( args, [&caching]( const std::string& arg )
+  {
+    return arg == "--cached" && (caching = Caching::Cached, true);
+  } );
+
+  if( args.size() < 2 )
+  {
+    std::cerr << "usage: TransferSweep <from> <to> [chunk MB,...] [depth,...] [--cached]"
+              << std::endl;
+    return 1;
+  }
+
+  try
+  {
+    const std::string& from = args[0];
+    const std::string& to   = args[1];
+
+    const auto chunks = sizes( args.size() > 2 ? args[2] : "1,2,4,8,16,32" );
+    const auto depths = sizes( args.size() > 3 ? args[3] : "2,4,8,16" );
+
+    const size_t fileSize = Stat {from}.size();
+
+    std::cout << "MB/s " << std::setw(8) << "depth";
+
+    for( auto depth : depths )
+    {
+      std::cout << std::setw(8) << depth;
+    }
+
+    std::cout << "\nchunk MB" << std::endl;
+
+    for( auto chunk : chunks )
+    {
+      std::cout << std::setw(13) << chunk;
+
+      for( auto depth : depths )
+      {
+        BufferPool::Settings settings {BufferPool::instance().settings()};
+
+        settings.chunkSize = chunk*1024*1024;
+        settings.depth     = depth;
+
+        BufferPool::instance().configure( settings );
+
+        std::cout << std::setw(8) << std::fixed << std::setprecision(0)
+                  << rate( from, to, fileSize, caching ) << std::flush;
+      }
+
+      std::cout << std::endl;
+    }
+
+    unlink( to.c_str() );
+  }
+  catch( const std::exception& e )
+  {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,73 @@
+/******************************* C++ Header File *******************************
+*
+*  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+*
+*  MODULE:      system
+*
+*  DESCRIPTION: Transfer of many files as one stream.
+*
+*******************************************************************************/
+
+#pragma once
+
+#include "FileSender.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace masuma::system
+{
+  // A batch is each file's header, name and data back to back, ended by a
+  // header with an empty name.  The header's fields are big endian; mode
+  // is the file's permissions.
+  //
+  struct BatchHeader
+  {
+    uint32_t nameLength;
+    uint32_t mode;
+    uint64_t size;
+  };
+
+  // Sends a list of files, named relative to root (a Scanner's regular
+  // files, for example), through one pipeline: small files are packed
+  // together into the pool's buffers rather than each having its own
+  // transfer and writer thread.
+  //
+  // Files that can't be opened, or aren't regular, are reported and
+  // skipped.  A file that shrinks while being sent is padded with zeros to
+  // the size sent in its header.
+  //
+  class BatchSender : public FileSender
+  {
+    size_t readFiles( const std::string& root, const std::vector<std::string>& );
+
+  public:
+
+    using FileSender::FileSender;
+
+    // Returns the number of files sent.
+    //
+    static size_t send( AutoFd to, const std::string& root, const std::vector<std::string>&,
+                        TransferReport* = nullptr );
+  };
+
+  // Unpacks a batch into directory, creating any directories in the names.
+  // The stream is read into the pool's buffers a buffer at a time, and each
+  // buffer's files are created and written by one of threads workers while
+  // the next is read, so that many small files are created in parallel.  A
+  // file spanning buffers is written a piece at a time by pwrite().
+  //
+  // Names are relative to directory; one that isn't is an error.
+  //
+  class BatchReceiver
+  {
+  public:
+
+    // Returns the number of files received.
+    //
+    static size_t receive( AutoFd from, const std::string& directory,
+                           TransferReport* = nullptr,
+                           unsigned threads = std::thread::hardware_concurrency() );
+  };
+}
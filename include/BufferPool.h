@@ -0,0 +1,121 @@
+/******************************* C++ Header File *******************************
+*
+*  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+*
+*  MODULE:      system
+*
+*  DESCRIPTION: Process wide pool of transfer buffers.
+*
+*******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace masuma::system
+{
+  // The buffers used by file transfers, kept for the life of the process so
+  // that each transfer doesn't allocate (and fault in) its own.
+  //
+  // A transfer leases depth chunks of chunkSize (rounded up to whole pages,
+  // so a chunk's worth of a file stays aligned) and returns them when the
+  // Lease goes; chunks are only allocated when none are idle.  Chunks are
+  // mapped anonymously, so are page aligned (which O_DIRECT needs), or
+  // aligned to and advised as huge pages.  Locked chunks are mlock()ed as
+  // they are allocated, so transfers never wait on them being paged.
+  //
+  // The settings can be changed with configure() while nothing is leased,
+  // which releases the idle chunks if their size or placement changes.
+  //
+  class BufferPool
+  {
+  public:
+
+    enum Alignment { Page, HugePage };
+
+    struct Settings
+    {
+      size_t    chunkSize {8*1024*1024};
+      size_t    depth     {8};
+      Alignment alignment {Page};
+      bool      locked    {false};
+    };
+
+    class Lease
+    {
+      friend class BufferPool;
+
+      BufferPool*           pool {nullptr};
+      std::vector<uint8_t*> chunks;
+
+      Lease( BufferPool* pool, std::vector<uint8_t*> chunks )
+        : pool {pool}, chunks {std::move(chunks)} {}
+
+    public:
+
+      Lease() = default;
+
+      Lease( Lease&& other ) noexcept
+        : pool {other.pool}, chunks {std::move(other.chunks)} { other.pool = nullptr; }
+
+      Lease& operator=( Lease&& other ) noexcept
+      {
+        std::swap( pool, other.pool );
+        std::swap( chunks, other.chunks );
+
+        return *this;
+      }
+
+      ~Lease() { if( pool ) pool->release( chunks ); }
+
+      [[nodiscard]] size_t size() const { return chunks.size(); }
+
+      uint8_t* operator[]( size_t n ) const { return chunks[n]; }
+
+      auto begin() const { return chunks.begin(); }
+      auto end() const { return chunks.end(); }
+    };
+
+  private:
+
+    mutable std::mutex mutex;
+
+    Settings current;
+    size_t   mappedSize;             // chunkSize rounded to the alignment.
+
+    std::vector<uint8_t*> idle;
+    size_t                leased {0};
+
+    BufferPool();
+
+    uint8_t* allocate() const;
+    void free( uint8_t* ) const;
+
+    void release( std::vector<uint8_t*>& );
+
+  public:
+
+    BufferPool( const BufferPool& ) = delete;
+    BufferPool& operator=( const BufferPool& ) = delete;
+
+    ~BufferPool();
+
+    static BufferPool& instance();
+
+    void configure( const Settings& );
+
+    [[nodiscard]] Settings settings() const;
+    [[nodiscard]] size_t chunkSize() const;
+
+    // depth chunks, or count if it isn't 0.
+    //
+    Lease lease( size_t count = 0 );
+
+    // Allocates chunks until count are idle.
+    //
+    void reserve( size_t count );
+  };
+}
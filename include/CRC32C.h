@@ -0,0 +1,73 @@
+/******************************* C++ Header File *******************************
+*
+*  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+*
+*  MODULE:      system
+*
+*  DESCRIPTION: CRC-32C (Castagnoli) checksum.
+*
+*******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+namespace masuma::system
+{
+  // Uses the SSE4.2 crc32 instruction on three interleaved streams where the
+  // CPU has it, otherwise a slicing-by-8 table.
+  //
+  uint32_t crc32c( uint32_t crc, const void* buf, size_t size );
+
+  struct CRC32CSum
+  {
+    uint32_t value {0};
+
+    bool operator==( const CRC32CSum& other ) const { return value == other.value; }
+    bool operator<( const CRC32CSum& other ) const { return value < other.value; }
+
+    operator std::string() const
+    {
+      std::ostringstream os;
+
+      os << *this;
+
+      return os.str();
+    }
+
+    friend std::ostream& operator<<( std::ostream& out, const CRC32CSum& sum )
+    {
+      return out << std::hex << std::setfill('0') << std::setw(8) << sum.value
+                 << std::dec << std::setfill(' ');
+    }
+
+    static CRC32CSum hash( const uint8_t* start, size_t size )
+    {
+      return {crc32c( 0, start, size )};
+    }
+  };
+
+  class CRC32CHash
+  {
+    uint32_t crc {0};
+
+  public:
+
+    using Sum = CRC32CSum;
+
+    void update( const void* buf, size_t size )
+    {
+      crc = crc32c( crc, buf, size );
+    }
+
+    void sum( CRC32CSum& result )
+    {
+      result.value = crc;
+    }
+  };
+}
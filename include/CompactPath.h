@@ -0,0 +1,162 @@
+/******************************* C++ Header File *******************************
+*
+*  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+*
+*  MODULE:      system
+*
+*  DESCRIPTION: Path held as a single shared buffer.
+*
+*******************************************************************************/
+
+#pragma once
+
+#include "Path.h"
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace masuma::system
+{
+  // The same components as a Path, stored as the joined string and the end
+  // offset of each component in one shared, immutable allocation:
+  //
+  //   ends[stored] | text
+  //
+  // A CompactPath is a view of the first size() components of its block, so
+  // copying one, or taking its tail(), is a reference count increment, and the
+  // full string form is the text itself rather than being rebuilt.
+  //
+  class CompactPath
+  {
+    std::shared_ptr<uint32_t[]> block;
+
+    uint32_t stored {0};    // Components in block.
+    uint32_t count  {0};    // Components in this path.
+
+    const uint32_t* ends() const { return block.get(); }
+
+    const char* text() const
+    {
+      return reinterpret_cast<const char*>(block.get()+stored);
+    }
+
+    // Component n is text[begin(n),ends[n]).
+    //
+    size_t begin( size_t n ) const { return n ? ends()[n-1]+1 : 0; }
+
+    void assign( std::string_view joined, uint32_t components );
+
+  public:
+
+    class const_iterator
+    {
+      const CompactPath* path {nullptr};
+      size_t             n {0};
+
+    public:
+
+      using iterator_category = std::forward_iterator_tag;
+      using value_type        = std::string_view;
+      using difference_type   = std::ptrdiff_t;
+      using pointer           = const std::string_view*;
+      using reference         = std::string_view;
+
+      const_iterator() = default;
+      const_iterator( const CompactPath* path, size_t n ) : path {path}, n {n} {}
+
+      std::string_view operator*() const { return (*path)[n]; }
+
+      const_iterator& operator++() { ++n; return *this; }
+      const_iterator operator++( int ) { auto was = *this; ++n; return was; }
+
+      bool operator==( const const_iterator& other ) const { return n == other.n; }
+      bool operator!=( const const_iterator& other ) const { return n != other.n; }
+    };
+
+    CompactPath() = default;
+
+    // Split as Path( std::string ) would.
+    //
+    explicit CompactPath( std::string_view );
+    explicit CompactPath( const std::string& s ) : CompactPath {std::string_view {s}} {}
+    explicit CompactPath( const char* s ) : CompactPath {std::string_view {s}} {}
+
+    explicit CompactPath( const Path& );
+
+    [[nodiscard]] size_t size() const { return count; }
+    [[nodiscard]] bool empty() const { return count == 0; }
+
+    std::string_view operator[]( size_t n ) const
+    {
+      return {text()+begin( n ), ends()[n]-begin( n )};
+    }
+
+    const_iterator begin() const { return {this, 0}; }
+    const_iterator end() const { return {this, count}; }
+
+    std::string_view head() const { return (*this)[count-1]; }
+
+    // The path without its last component, sharing this one's block.
+    //
+    CompactPath tail() const
+    {
+      CompactPath result {*this};
+      --result.count;
+      return result;
+    }
+
+    // The components joined with '/'.
+    //
+    std::string_view view() const
+    {
+      return {text(), count ? ends()[count-1] : 0};
+    }
+
+    operator std::string() const { return std::string {view()}; }
+
+    Path path() const;
+
+    bool operator==( const CompactPath& other ) const
+    {
+      return count == other.count && view() == other.view();
+    }
+
+    bool operator!=( const CompactPath& other ) const
+    {
+      return !operator==( other );
+    }
+
+    bool isParentOf( const CompactPath& other ) const
+    {
+      if( count >= other.count )
+      {
+        return false;
+      }
+
+      if( count == 0 )
+      {
+        return true;
+      }
+
+      const std::string_view mine {view()};
+
+      return other.view().starts_with( mine ) && other.view()[mine.size()] == '/';
+    }
+
+    bool isChildOf( const CompactPath& other ) const
+    {
+      return other.isParentOf( *this );
+    }
+
+    friend CompactPath operator+( const CompactPath&, const CompactPath& );
+  };
+
+  inline std::ostream&
+  operator<<( std::ostream& out, const CompactPath& path )
+  {
+    return out << path.view();
+  }
+}
@@ -0,0 +1,224 @@
+/******************************* C++ Header File *******************************
+*
+*  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+*
+*  MODULE:      system
+*
+*  DESCRIPTION: Vectorised delimiter search and line/field splitting.
+*
+*******************************************************************************/
+
+#pragma once
+
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <streambuf>
+#include <string_view>
+#include <vector>
+
+namespace masuma::system
+{
+  // One to eight delimiter bytes.
+  //
+  class DelimiterSet
+  {
+    uint8_t bytes[8] {};
+    size_t  count {0};
+    bool    table[256] {};
+
+  public:
+
+    DelimiterSet( std::string_view delimiters )
+      : count {delimiters.size()}
+    {
+      CheckConditionM( count > 0 && count <= sizeof bytes, "1 to 8 delimiters" );
+
+      for( size_t n = 0; n < count; ++n )
+      {
+        bytes[n] = delimiters[n];
+        table[bytes[n]] = true;
+      }
+    }
+
+    DelimiterSet( char delimiter ) : DelimiterSet {std::string_view {&delimiter, 1}} {}
+
+    [[nodiscard]] size_t size() const { return count; }
+
+    uint8_t operator[]( size_t n ) const { return bytes[n]; }
+
+    [[nodiscard]] bool contains( uint8_t c ) const { return table[c]; }
+  };
+
+  // The scans compare 64 bytes at a time, with AVX2 or SSE2 chosen when
+  // first used, giving a bit per byte.
+  //
+  // delimiterBitmap() sets bit n%64 of bitmap[n/64] for each delimiter at
+  // data[n]; bitmap has (size+63)/64 words.
+  //
+  void delimiterBitmap( const char* data, size_t size, const DelimiterSet&, uint64_t* bitmap );
+
+  // Appends the offset of each delimiter in data.
+  //
+  void findDelimiters( const char* data, size_t size, const DelimiterSet&,
+                       std::vector<size_t>& offsets );
+
+  // The first delimiter in [begin,end), or end.
+  //
+  const char* findDelimiter( const char* begin, const char* end, const DelimiterSet& );
+
+  // The fields between delimiters in a buffer, such as the lines of a
+  // MappedFile.  A delimiter ending the buffer doesn't start another field,
+  // so "a\nb\n" and "a\nb" are both two lines, and an empty buffer has none.
+  // The buffer and the Fields must outlive the iterators.
+  //
+  class Fields
+  {
+    const char*  data;
+    size_t       length;
+    DelimiterSet delimiters;
+
+  public:
+
+    class iterator
+    {
+      static constexpr size_t windowWords {16};
+
+      const Fields* fields {nullptr};
+
+      size_t start  {0};
+      size_t finish {0};
+
+      // Delimiters not yet used are the set bits in window[word..loaded),
+      // which covers the buffer from windowBase.
+      //
+      uint64_t window[windowWords];
+      size_t   windowBase {0};
+      size_t   windowEnd  {0};
+      size_t   word       {0};
+      size_t   loaded     {0};
+
+      size_t nextDelimiter()
+      {
+        while( true )
+        {
+          for( ; word < loaded; ++word )
+          {
+            if( const uint64_t bits = window[word] )
+            {
+              window[word] = bits & (bits-1);
+
+              return windowBase+word*64+std::countr_zero( bits );
+            }
+          }
+
+          if( windowEnd >= fields->length )
+          {
+            return fields->length;
+          }
+
+          const size_t size = std::min( windowWords*64, fields->length-windowEnd );
+
+          delimiterBitmap( fields->data+windowEnd, size, fields->delimiters, window );
+
+          windowBase = windowEnd;
+          windowEnd += size;
+          word       = 0;
+          loaded     = (size+63)/64;
+        }
+      }
+
+    public:
+
+      using iterator_category = std::input_iterator_tag;
+      using value_type        = std::string_view;
+      using difference_type   = std::ptrdiff_t;
+      using pointer           = const std::string_view*;
+      using reference         = std::string_view;
+
+      iterator() = default;
+
+      explicit iterator( const Fields* f ) : fields {f}
+      {
+        if( fields->length == 0 )
+        {
+          fields = nullptr;
+          return;
+        }
+
+        finish = nextDelimiter();
+      }
+
+      std::string_view operator*() const { return {fields->data+start, finish-start}; }
+
+      // The field's offset in the buffer.
+      //
+      [[nodiscard]] size_t offset() const { return start; }
+
+      iterator& operator++()
+      {
+        if( finish+1 >= fields->length )
+        {
+          fields = nullptr;
+        }
+        else
+        {
+          start  = finish+1;
+          finish = nextDelimiter();
+        }
+
+        return *this;
+      }
+
+      bool operator==( const iterator& other ) const
+      {
+        return fields == other.fields && (!fields || start == other.start);
+      }
+
+      bool operator!=( const iterator& other ) const { return !operator==( other ); }
+    };
+
+    Fields( const void* data, size_t size, const DelimiterSet& delimiters = '\n' )
+      : data {static_cast<const char*>(data)}, length {size}, delimiters {delimiters} {}
+
+    explicit Fields( std::string_view s, const DelimiterSet& delimiters = '\n' )
+      : Fields {s.data(), s.size(), delimiters} {}
+
+    explicit Fields( const MappedFile& file, const DelimiterSet& delimiters = '\n' )
+      : Fields {file.begin(), file.size(), delimiters} {}
+
+    iterator begin() const { return iterator {this}; }
+    iterator end() const { return {}; }
+  };
+
+  // Fields read through a streambuf (an IStreambuf, or a file or string
+  // buffer) a block at a time, with the same rules as Fields.  A field stays
+  // valid until the next call to next().
+  //
+  class FieldReader
+  {
+    std::streambuf&   in;
+    DelimiterSet      delimiters;
+    std::vector<char> buffer;
+
+    size_t begin   {0};    // Of the next field.
+    size_t scanned {0};    // Delimiter free from begin to here.
+    size_t end     {0};    // Of the data read.
+    bool   eof     {false};
+
+    void fill();
+
+  public:
+
+    FieldReader( std::streambuf& in, const DelimiterSet& delimiters = '\n',
+                 size_t bufferSize = 64*1024 )
+      : in {in}, delimiters {delimiters}, buffer( bufferSize )
+    {
+      CheckCondition( bufferSize > 0 );
+    }
+
+    bool next( std::string_view& field );
+  };
+}
@@ -0,0 +1,148 @@
+/******************************* C++ Header File *******************************
+*
+*  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+*
+*  MODULE:      system
+*
+*  DESCRIPTION: Rsync style delta transfer of a changed file.
+*
+*******************************************************************************/
+
+#pragma once
+
+#include "FileSender.h"
+#include "FileReceiver.h"
+#include "XXH3.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace masuma::system
+{
+  // rsync's rolling checksum of a window of bytes: a is their sum and b the
+  // sum of the partial sums of a, each modulo 2^16, so that moving the
+  // window along a byte is a couple of additions.
+  //
+  class RollingChecksum
+  {
+    uint32_t a      {0};
+    uint32_t b      {0};
+    uint32_t length {0};
+
+  public:
+
+    RollingChecksum() = default;
+
+    RollingChecksum( const uint8_t* data, size_t size ) : length {static_cast<uint32_t>(size)}
+    {
+      for( size_t n = 0; n < size; ++n )
+      {
+        a += data[n];
+        b += a;
+      }
+    }
+
+    // Drops out from the front of the window and adds in at the back.
+    //
+    void roll( uint8_t out, uint8_t in )
+    {
+      a += in-out;
+      b += a-length*out;
+    }
+
+    [[nodiscard]] uint32_t digest() const { return (a & 0xffff) | (b << 16); }
+  };
+
+  // The receiver's copy of a file, as the rolling and strong checksums of
+  // each block.  The last block may be short.
+  //
+  struct Signature
+  {
+    struct Block
+    {
+      uint32_t    weak;
+      XXH3_128Sum strong;
+    };
+
+    uint32_t           blockSize {0};
+    uint64_t           fileSize  {0};
+    std::vector<Block> blocks;
+
+    // As rsync chooses: the square root of the size, between 700 bytes and
+    // 128 KB.
+    //
+    static uint32_t blockSizeFor( uint64_t fileSize );
+
+    static Signature of( AutoFd, uint32_t blockSize = 0 );
+    static Signature of( const std::string&, uint32_t blockSize = 0 );
+
+    void send( AutoFd ) const;
+    static Signature receive( AutoFd );
+  };
+
+  // A delta is a sequence of instructions, each a header followed by any
+  // data: a Literal's length bytes, a Copy of length blocks of the basis
+  // starting at block value, and an End giving the file's length.  The
+  // header's fields are big endian.
+  //
+  struct DeltaHeader
+  {
+    enum Kind : uint64_t { Literal = 1, Copy, End };
+
+    uint64_t kind;
+    uint64_t value;
+    uint64_t length;
+  };
+
+  // Syncing a file the receiver has an older copy of (the basis):
+  //
+  //   receiver:  Signature signature {Signature::of( basis )};
+  //              signature.send( socket );
+  //              DeltaReceiver::receive( socket, basis, signature, to, size );
+  //
+  //   sender:    DeltaSender::send( socket, from, size, Signature::receive( socket ) );
+  //
+  // The sender runs a rolling window over its file looking up each
+  // position's checksum in the signature, confirming a match with the
+  // strong checksum, and sends the runs of matching blocks as Copy
+  // instructions and everything between them as Literals.
+  //
+  class DeltaSender : public FileSender
+  {
+    void putHeader( uint64_t kind, uint64_t value, uint64_t length );
+
+    void scan( const uint8_t*, size_t, const Signature& );
+
+  public:
+
+    using FileSender::FileSender;
+
+    static void send( AutoFd to, AutoFd from, size_t, const Signature&,
+                      TransferReport* = nullptr );
+    static void send( AutoFd to, const std::string& from, size_t, const Signature&,
+                      TransferReport* = nullptr );
+  };
+
+  class DeltaReceiver : public FileReceiver
+  {
+    void readBasis( const AutoFd&, uint64_t offset, uint64_t length );
+
+    void readDelta( const AutoFd& basis, const Signature&, size_t );
+
+  public:
+
+    using FileReceiver::FileReceiver;
+
+    // Writes the new file to to from the delta and basis, the file from
+    // which signature was made.
+    //
+    static void receive( AutoFd from, AutoFd basis, const Signature&, AutoFd to, size_t,
+                         TransferReport* = nullptr );
+
+    // Replaces file, the basis, once the new one has been received.
+    //
+    static void receive( AutoFd from, const std::string& file, const Signature&, size_t,
+                         TransferReport* = nullptr );
+  };
+}
@@ -13,11 +13,20 @@
 
 #include "MessageQueue.h"
 #include "AutoFd.h"
+#include "TransferReport.h"
+#include "BufferPool.h"
+
+#include <unistd.h>
 
 namespace masuma
 {
   namespace system
   {
+    // Whether the file end of a transfer goes through the page cache.  An
+    // Uncached transfer of a large file doesn't evict everything else.
+    //
+    enum class Caching { Cached, Uncached };
+
     class FileCommon
     {
     public:
@@ -25,35 +34,114 @@ namespace masuma
       using Item  = std::pair<uint8_t*,size_t>;
       using Queue = StaticMessageQueue<Item>;
 
+      // O_DIRECT needs buffers, offsets and lengths aligned to the logical
+      // block size; this covers any in use.
+      //
+      static constexpr size_t alignment {4096};
+
+      // A sparse transfer is a sequence of extents, each a header of the
+      // extent's offset and length followed by its data, the gaps between
+      // them being holes.  An empty extent at the file's size ends it.  The
+      // header's fields are big endian.
+      //
+      struct ExtentHeader
+      {
+        uint64_t offset;
+        uint64_t length;
+      };
+
     protected:
 
+      // Reads or writes the file end of an Uncached transfer sequentially
+      // from the descriptor's offset.  O_DIRECT is set on the descriptor if the filesystem
+      // allows it; a final block that isn't whole is read by rounding the
+      // length up, and written with O_DIRECT cleared.  Otherwise each
+      // buffer's pages are dropped from the cache with POSIX_FADV_DONTNEED
+      // once read, or once written back (write back of one being started
+      // before waiting on the previous).  The descriptor's flags are restored
+      // and anything outstanding dropped on destruction.
+      //
+      class Uncached
+      {
+        AutoFd fd;
+
+        int   flags;
+        bool  direct  {false};
+        off_t offset  {0};     // Next read or write.
+        off_t dropped {0};     // Written back and dropped to here.
+
+      public:
+
+        explicit Uncached( AutoFd );
+        ~Uncached();
+
+        Uncached( const Uncached& ) = delete;
+        Uncached& operator=( const Uncached& ) = delete;
+
+        void read( uint8_t*, size_t );
+        void write( const uint8_t*, size_t );
+
+        // Moves as lseek() does, after dropping anything outstanding.
+        //
+        void seek( off_t, int whence = SEEK_SET );
+      };
+
       AutoFd& from;
       AutoFd& to;
 
       Queue& readyQueue;
       Queue& doneQueue;
 
-     static uint8_t* initialiseQueue( Queue& );
+      TransferReport* report;
+
+      Uncached* uncachedFrom {nullptr};
+      Uncached* uncachedTo   {nullptr};
+
+      Item pending {nullptr,0};           // Being packed by put().
+
+      // Leases a transfer's buffers from the pool and posts them to the
+      // queue; they go back to the pool with the lease.
+      //
+      static BufferPool::Lease initialiseQueue( Queue& );
 
       void readFile( size_t );
+      void readRange( size_t );
+
+      // Pack data back to back into the writer's items, each being passed
+      // on when full or flushed.  putFrom() returns what it read, less than
+      // size if the file ends.
+      //
+      void put( const void*, size_t );
+      size_t putFrom( AutoFd, size_t );
+      void flush();
 
       virtual void doneWith( Item );
 
       static void readToItem( AutoFd, Item& );
 
-      static void copyShortFile( AutoFd, AutoFd, size_t );
+      static void copyShortFile( AutoFd, AutoFd, size_t, TransferReport* = nullptr );
 
     public:
 
-      FileCommon( AutoFd& from, AutoFd& to, Queue& ready, Queue& done )
-        : from {from}, to {to}, readyQueue {ready}, doneQueue {done} {}
+      FileCommon( AutoFd& from, AutoFd& to, Queue& ready, Queue& done,
+                  TransferReport* report = nullptr )
+        : from {from}, to {to}, readyQueue {ready}, doneQueue {done},
+          report {report} {}
 
       FileCommon( const FileCommon& ) = default;
 
-      static const size_t bufferSize;
+      // The pool's chunk size, files shorter than which are copied without
+      // the pipeline.
+      //
+      static size_t bufferSize() { return BufferPool::instance().chunkSize(); }
 
       static void readToBuffer( AutoFd, uint8_t*, size_t );
 
+      // Drops the first size bytes of a file copied without the pipeline
+      // from the cache, once written back if it was written.
+      //
+      static void dropFromCache( AutoFd, size_t, bool written );
+
       void operator()();
     };
   }
@@ -0,0 +1,45 @@
+/******************************* C++ Header File *******************************
+*
+*  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+*
+*  MODULE:      system
+*
+*  DESCRIPTION: Copy between local files by the fastest means available.
+*
+*******************************************************************************/
+
+#pragma once
+
+#include "FileCommon.h"
+
+#include <iosfwd>
+#include <string>
+
+namespace masuma::system
+{
+  enum class CopyMethod
+  {
+    Reflink,          // ioctl(FICLONE), sharing the source's extents.
+    CopyFileRange,    // copy_file_range(), in the kernel or on the server.
+    Splice,           // splice() through a pipe.
+    Buffered          // The FileSender pipeline.
+  };
+
+  std::ostream& operator<<( std::ostream&, CopyMethod );
+
+  // Copies the whole of from to to (which should be empty), trying each
+  // CopyMethod in turn until one is accepted, and returns the one that
+  // finished the copy.  A method failing part way through hands over to the
+  // next from where it stopped.
+  //
+  // Reflinks make a copy on btrfs or XFS almost instantly; copy_file_range
+  // lets the kernel, or an NFS 4.2 server, copy without the data passing
+  // through user space.  An Uncached copy drops both files' pages from the
+  // cache once the data has been copied.
+  //
+  CopyMethod copyFile( AutoFd from, AutoFd to, TransferReport* = nullptr,
+                       Caching = Caching::Cached );
+
+  CopyMethod copyFile( const std::string& from, const std::string& to,
+                       TransferReport* = nullptr, Caching = Caching::Cached );
+}
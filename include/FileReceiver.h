@@ -19,12 +19,25 @@ namespace masuma
   {
     class FileReceiver : public FileCommon
     {
+      void readExtents( size_t );
+
     public:
 
       using FileCommon::FileCommon;
 
-      static void receive( AutoFd from, const std::string&, size_t );
-      static void receive( AutoFd from, AutoFd to, size_t );
+      static void receive( AutoFd from, const std::string&, size_t,
+                           TransferReport* = nullptr, Caching = Caching::Cached );
+      static void receive( AutoFd from, AutoFd to, size_t, TransferReport* = nullptr,
+                           Caching = Caching::Cached );
+
+      // Receives the extents sent by FileSender::sendSparse(), replacing the
+      // contents of to.  Holes are left by seeking over them, so the file
+      // is only allocated where there is data.
+      //
+      static void receiveSparse( AutoFd from, const std::string&, size_t,
+                                 TransferReport* = nullptr, Caching = Caching::Cached );
+      static void receiveSparse( AutoFd from, AutoFd to, size_t, TransferReport* = nullptr,
+                                 Caching = Caching::Cached );
     };
   }
 }
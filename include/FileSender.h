@@ -12,6 +12,10 @@
 #define _utils_FileSender_h_
 
 #include "FileCommon.h"
+#include "MD5.h"
+
+#include <thread>
+#include <memory>
 
 #include <fcntl.h>
 #include <unistd.h>
@@ -22,12 +26,27 @@ namespace masuma
   {
     class FileSender : public FileCommon
     {
+      void postHeader( uint64_t offset, uint64_t length );
+
+      void readExtents( size_t );
+
     public:
 
       using FileCommon::FileCommon;
 
-      static void send( AutoFd to, const std::string& from, size_t );
-      static void send( AutoFd to, AutoFd from, size_t );
+      static void send( AutoFd to, const std::string& from, size_t,
+                        TransferReport* = nullptr, Caching = Caching::Cached );
+      static void send( AutoFd to, AutoFd from, size_t, TransferReport* = nullptr,
+                        Caching = Caching::Cached );
+
+      // Sends only the file's data, found with SEEK_DATA and SEEK_HOLE, as
+      // the extents FileReceiver::receiveSparse() expects.  Where the
+      // filesystem can't find holes the file is sent as one extent.
+      //
+      static void sendSparse( AutoFd to, const std::string& from, size_t,
+                              TransferReport* = nullptr, Caching = Caching::Cached );
+      static void sendSparse( AutoFd to, AutoFd from, size_t, TransferReport* = nullptr,
+                              Caching = Caching::Cached );
     };
 
 //    template <typename process>
@@ -38,7 +57,7 @@ namespace masuma
 //        Queue readyQueue;
 //        Queue doneQueue;
 //
-//        std::unique_ptr<uint8_t> buffer {initialiseQueue( doneQueue )};
+//        const BufferPool::Lease buffers {initialiseQueue( doneQueue )};
 //
 //        FileSender sender {from, to, readyQueue, doneQueue};
 //
@@ -61,23 +80,127 @@ namespace masuma
 {
   namespace system
   {
-    struct Summer;
+    // Hashes the items passing through a HashingFileSender on its own thread
+    // and stores the sum in result at the end of the file.  Hash needs update(), sum()
+    // and a streamable Hash::Sum: MD5Hash, CRC32CHash, XXH3Hash, XXH3_128Hash.
+    //
+    template <typename Hash>
+    struct Summer
+    {
+      Hash sum;
+
+      typename Hash::Sum& result;
+
+      using Queue = FileCommon::Queue;
+      using Item  = FileCommon::Item;
+
+      Queue& itemQueue;
+      Queue& readyQueue;
+
+      Summer( typename Hash::Sum& result, Queue& itemQueue, Queue& readyQueue )
+        : result {result}, itemQueue {itemQueue}, readyQueue {readyQueue} {}
 
-    class SummingFileSender : public FileSender
+      Summer( const Summer& ) = default;
+
+      void operator()()
+      {
+        Item item {nullptr,42};
+
+        while( item.second )
+        {
+          itemQueue.pend( item );
+
+          if( item.second )
+          {
+            sum.update( item.first, item.second );
+          }
+          else
+          {
+            sum.sum( result );
+          }
+
+          readyQueue.post(item);
+        }
+      }
+
+      void post( const Item& item ) { itemQueue.post( item ); }
+    };
+
+    template <typename Hash>
+    class HashingFileSender : public FileSender
     {
-      friend struct Summer;
+      friend struct Summer<Hash>;
 
-      static Summer* summer;
+      static inline Summer<Hash>* summer {nullptr};
 
-      void doneWith( Item );
+      void doneWith( Item item ) override
+      {
+        summer->post( item );
+      }
 
     public:
 
       using FileSender::FileSender;
 
-      static void send( AutoFd to, const std::string& from, size_t );
-      static void send( AutoFd to, AutoFd from, size_t );
+      // Returns the sum of the data sent.
+      //
+      static typename Hash::Sum send( AutoFd to, const std::string& from, size_t,
+                                      TransferReport* = nullptr );
+      static typename Hash::Sum send( AutoFd to, AutoFd from, size_t,
+                                      TransferReport* = nullptr );
     };
+
+    template <typename Hash> typename Hash::Sum
+    HashingFileSender<Hash>::send( AutoFd to, AutoFd from, size_t fileSize,
+                                   TransferReport* report )
+    {
+      typename Hash::Sum result {};
+
+      Queue readyQueue;
+      Queue doneQueue;
+      Queue summerQueue;
+
+      const BufferPool::Lease buffers {initialiseQueue( doneQueue )};
+
+      Summer<Hash> sum {result, summerQueue, readyQueue};
+
+      summer = &sum;
+
+      std::thread summing {sum};
+
+      HashingFileSender sender {from, to, readyQueue, doneQueue, report};
+
+      std::thread sending {sender};
+
+      try
+      {
+        sender.readFile( fileSize );
+      }
+      catch( ... )
+      {
+        sender.doneWith( {nullptr,0} );
+        sending.join();
+        summing.join();
+
+        throw;
+      }
+
+      sending.join();
+      summing.join();
+
+      return result;
+    }
+
+    template <typename Hash> typename Hash::Sum
+    HashingFileSender<Hash>::send( AutoFd to, const std::string& file, size_t fileSize,
+                                   TransferReport* report )
+    {
+      AutoFd from {open, file.c_str(), O_RDONLY};
+
+      return send( to, from, fileSize, report );
+    }
+
+    using SummingFileSender = HashingFileSender<MD5Hash>;
   }
 }
 
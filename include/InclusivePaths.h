@@ -11,37 +11,69 @@
 
 #include "Path.h"
 
+#include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace masuma
 {
   namespace system
   {
-    class InclusivePaths : std::vector<Path>
+    // A set of paths where none is below another: adding a path drops any
+    // below it and adding one below an existing path does nothing.  They are
+    // held in a trie of path components, so adding, removing and asking
+    // whether a path is covered cost the path's depth (plus whatever is
+    // dropped), not the number of paths.  Removal moves the last path into
+    // the gap, so the order isn't that of insertion.
+    //
+    class InclusivePaths
     {
-      using Base = std::vector<Path>;
+      static constexpr size_t npos {~size_t {0}};
+
+      struct Node
+      {
+        std::unordered_map<std::string,std::unique_ptr<Node>> children;
+
+        size_t index {npos};    // In paths, if a path ends here.
+      };
+
+      std::unique_ptr<Node> root {std::make_unique<Node>()};
+
+      std::vector<Path>  paths;
+      std::vector<Node*> owners;
+
+      Node* find( const Path& path ) const;
+
+      void erase( size_t index );
+      void eraseBelow( Node& node );
+      void prune( const Path& path );
 
     public:
 
-      using Base::const_iterator;
-      using Base::size;
-      using Base::empty;
-      using Base::operator[];
-      using Base::begin;
-      using Base::end;
-      using Base::clear;
+      using const_iterator = std::vector<Path>::const_iterator;
 
       InclusivePaths() = default;
       virtual ~InclusivePaths() = default;
 
-      InclusivePaths( const InclusivePaths& ) = default;
-      InclusivePaths( InclusivePaths&& ) = default;
-      InclusivePaths& operator=( const InclusivePaths& ) = default;
-      InclusivePaths& operator=( InclusivePaths&& ) = default;
+      InclusivePaths( const InclusivePaths& );
+      InclusivePaths( InclusivePaths&& );
+      InclusivePaths& operator=( const InclusivePaths& );
+      InclusivePaths& operator=( InclusivePaths&& );
 
       explicit InclusivePaths( const Strings& );
       explicit InclusivePaths( const Paths& );
 
+      [[nodiscard]] size_t size() const { return paths.size(); }
+      [[nodiscard]] bool empty() const { return paths.empty(); }
+
+      const Path& operator[]( size_t n ) const { return paths[n]; }
+
+      const_iterator begin() const { return paths.begin(); }
+      const_iterator end() const { return paths.end(); }
+
+      void clear();
+
       InclusivePaths& operator<<( const Path& );
 
       InclusivePaths& operator<<( const std::string& path )
@@ -51,6 +83,10 @@ namespace masuma
 
       InclusivePaths& operator<<( const Paths& );
 
+      // Is path one of these or below one?
+      //
+      [[nodiscard]] bool includes( const Path& path ) const;
+
       void removeChildrenOf( const Path& path );
       void removePathAndChildren( const Path& path );
     };
@@ -0,0 +1,323 @@
+/******************************* C++ Header File *******************************
+*
+*  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+*
+*  MODULE:      system
+*
+*  DESCRIPTION: Directory scanner that only reports changes since the last
+*               scan.
+*
+*******************************************************************************/
+
+#pragma once
+
+#include "Scanner.h"
+#include "ScanSnapshot.h"
+
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace masuma::system
+{
+  // Scans against the snapshot written by the previous scan and writes a new
+  // one.  A directory whose ctime and mtime match its snapshot record (looked
+  // up by device and inode) is not read; its children are taken from the
+  // snapshot and only its subdirectories are visited.  A changed directory is
+  // read and each entry compared with its old record, so that
+  //
+  //   processFile()/processOther() are called for added or modified entries
+  //   (new name, new inode, or a different size or mtime),
+  //
+  //   processRemoved( path, type, data ) is called, if Actions has it, for
+  //   entries that have gone; a removed directory is reported on its own, not
+  //   its contents.
+  //
+  // processDirectory() is called for every directory visited, as it decides
+  // whether to descend and provides the data for the children, and
+  // finishedDirectory() after each.  Everything below a new directory is new.
+  //
+  // Because an unchanged directory isn't read, a file rewritten in place
+  // below it (which changes the file's times but not the directory's) is not
+  // reported.
+  //
+  template <typename Actions, typename Traits = FilesystemTraits>
+  class IncrementalScanner
+  {
+    using DataType   = typename Actions::DataType;
+    using Directory  = typename Traits::Directory;
+    using Entry      = typename Directory::Entry;
+    using EntryType  = typename Directory::EntryType;
+    using ReturnType = std::pair<bool,DataType>;
+    using Child      = ScanSnapshot::ChildRecord;
+
+    Actions  own;
+    Actions& actions;
+
+    const DataType    root;
+    const std::string snapshotFile;
+
+    ScanSnapshot          previous;
+    ScanSnapshot::Builder next;
+
+    unsigned fileCount      {0};
+    unsigned directoryCount {0};
+    unsigned unchangedCount {0};
+    unsigned changeCount    {0};
+
+    static void statEntry( Stat& status, const Entry& entry )
+    {
+      if constexpr( requires { entry.directory().descriptor(); } )
+      {
+        status.reset( entry.directory().descriptor(), entry.value().d_name );
+      }
+      else
+      {
+        status.reset( entry.name() );
+      }
+    }
+
+    static void report( const std::string& filepath, const std::exception& e )
+    {
+      std::cerr << filepath << ' ' << e.what() << std::endl;
+    }
+
+    void removed( const Entry& parent, std::string_view name, FileType type,
+                  const DataType& data )
+    {
+      ++changeCount;
+
+      if constexpr( requires { actions.processRemoved( std::string {}, type, data ); } )
+      {
+        actions.processRemoved( parent.name()+'/'+std::string {name}, type, data );
+      }
+    }
+
+    void changed( const Entry& entry, FileType type, const DataType& data )
+    {
+      ++changeCount;
+
+      if( type == FileType::Regular )
+      {
+        actions.processFile( entry, data );
+      }
+      else
+      {
+        actions.processOther( entry, data );
+      }
+    }
+
+    void scanDirectory( const Entry& entry, const DataType& data, bool fresh )
+    {
+      Stat status;
+
+      statEntry( status, entry );
+
+      ++directoryCount;
+
+      const auto* old = fresh ? nullptr : previous.find( status.get().st_dev,
+                                                         status.get().st_ino );
+
+      Directory dir {entry};
+
+      ReturnType dirResult {actions.processDirectory( entry, dir, data )};
+
+      next.directory( status, dirResult.first );
+
+      if( !dirResult.first )
+      {
+        actions.finishedDirectory( entry );
+        return;
+      }
+
+      // Subdirectories, and whether each is new, visited once this
+      // directory's children have all been recorded.
+      //
+      std::vector<std::pair<EntryType,bool>> subdirectories;
+
+      if( old &&
+          old->changeTime == nanoseconds( status.changeTime() ) &&
+          old->modifyTime == nanoseconds( status.modifyTime() ) )
+      {
+        ++unchangedCount;
+
+        for( const Child* child = previous.begin( *old ); child != previous.end( *old ); ++child )
+        {
+          const std::string_view name {previous.name( *child )};
+
+          next.child( name, child->inode, child->modifyTime, child->size, child->type );
+
+          if( child->type == FileType::Regular )
+          {
+            ++fileCount;
+          }
+          else if( child->type == FileType::Directory )
+          {
+            EntryType value {};
+
+            value.d_ino  = child->inode;
+            value.d_type = DT_DIR;
+
+            name.copy( value.d_name, sizeof(value.d_name)-1 );
+
+            subdirectories.emplace_back( value, false );
+          }
+        }
+      }
+      else
+      {
+        std::unordered_map<std::string_view,const Child*> known;
+
+        if( old )
+        {
+          for( const Child* child = previous.begin( *old ); child != previous.end( *old ); ++child )
+          {
+            known.emplace( previous.name( *child ), child );
+          }
+        }
+
+        Stat childStatus;
+
+        for( auto it = dir.begin(); it != dir.end(); ++it )
+        {
+          const Entry child {*it};
+
+          try
+          {
+            statEntry( childStatus, child );
+
+            const std::string_view name {child.value().d_name};
+            const struct stat&     info {childStatus.get()};
+            const FileType         type {childStatus.fileType()};
+            const int64_t          modifyTime {nanoseconds( childStatus.modifyTime() )};
+
+            next.child( name, info.st_ino, modifyTime, info.st_size, type );
+
+            const Child* before {nullptr};
+
+            if( auto found = known.find( name ); found != known.end() )
+            {
+              before = found->second;
+              known.erase( found );
+            }
+
+            const bool added = !before || before->inode != info.st_ino || before->type != type;
+
+            // A directory replacing something, or replaced by something,
+            // is reported as the old entry going.
+            //
+            if( added && before &&
+                (type == FileType::Directory || before->type == FileType::Directory) )
+            {
+              removed( entry, name, before->type, dirResult.second );
+            }
+
+            if( type == FileType::Directory )
+            {
+              subdirectories.emplace_back( child.value(), added );
+              continue;
+            }
+
+            if( type == FileType::Regular )
+            {
+              ++fileCount;
+            }
+
+            if( added || before->size != info.st_size || before->modifyTime != modifyTime )
+            {
+              changed( child, type, dirResult.second );
+            }
+          }
+          catch( std::exception& e )
+          {
+            report( child.name(), e );
+          }
+        }
+
+        for( const auto& gone : known )
+        {
+          removed( entry, gone.first, gone.second->type, dirResult.second );
+        }
+      }
+
+      for( const auto& subdirectory : subdirectories )
+      {
+        const Entry child {&dir, &subdirectory.first};
+
+        try
+        {
+          scanDirectory( child, dirResult.second, fresh || subdirectory.second );
+        }
+        catch( std::exception& e )
+        {
+          report( child.name(), e );
+        }
+      }
+
+      actions.finishedDirectory( entry );
+    }
+
+  public:
+
+    IncrementalScanner( const DataType& root, const std::string& snapshotFile )
+      : actions {own}, root {root}, snapshotFile {snapshotFile}, previous {snapshotFile} {}
+
+    // Reports to actions rather than the scanner's own.
+    //
+    IncrementalScanner( Actions& actions, const DataType& root, const std::string& snapshotFile )
+      : actions {actions}, root {root}, snapshotFile {snapshotFile}, previous {snapshotFile} {}
+
+    IncrementalScanner( const IncrementalScanner& ) = delete;
+    IncrementalScanner& operator=( const IncrementalScanner& ) = delete;
+
+    // Scans root, reporting changes since the last scan, then replaces the
+    // snapshot.
+    //
+    void start()
+    {
+      fileCount = directoryCount = unchangedCount = changeCount = 0;
+
+      std::string dirPath {root};
+
+      if( dirPath.size() > 1 && *dirPath.rbegin() == '/' )
+      {
+        dirPath.erase(dirPath.begin()+(dirPath.size()-1));
+      }
+
+      auto tailHead = system::splitLast( dirPath, '/' );
+
+      if( tailHead.first.empty() )
+      {
+        tailHead.first = "/";
+      }
+
+      const Directory dir {tailHead.first, nullptr};
+
+      auto target = dir.find( tailHead.second );
+
+      CheckConditionM( target != dir.end(), dirPath );
+
+      scanDirectory( *target, root, false );
+
+      next.write( snapshotFile );
+
+      previous = ScanSnapshot {snapshotFile};
+      next     = {};
+    }
+
+    // The Actions the scan reports to, to set them up before start().
+    //
+    Actions& handler() { return actions; }
+
+    [[nodiscard]] unsigned files() const { return fileCount; }
+    [[nodiscard]] unsigned directories() const { return directoryCount; }
+
+    // Directories found unchanged and not read.
+    //
+    [[nodiscard]] unsigned unchanged() const { return unchangedCount; }
+
+    // Entries reported added, modified or removed.
+    //
+    [[nodiscard]] unsigned changes() const { return changeCount; }
+  };
+}
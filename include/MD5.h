@@ -78,6 +78,8 @@ namespace masuma
 
     public:
 
+      using Sum = MD5Sum;
+
       MD5Hash()
       {
         MD5_Init( &context );
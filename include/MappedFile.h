@@ -13,8 +13,11 @@
 
 #include "AutoFd.h"
 
+#include <algorithm>
 #include <memory>
 
+#include <sys/mman.h>
+
 namespace masuma::system
 {
   struct MmapException : Exception
@@ -23,15 +26,46 @@ namespace masuma::system
       : Exception( info, "Mmap: "+file ) {}
   };
 
+  // How a mapping will be used, applied when it is made.  All but numaNode
+  // are advice, so a kernel without (for example) transparent huge pages
+  // maps the file regardless.  A file on hugetlbfs gets huge pages without
+  // asking.
+  //
+  // The kernel places a shared file mapping's pages by the policy of the
+  // thread that faults them in, not the mapping's.  So numaNode moves the
+  // pages already resident to the node and, with populate, faults the rest
+  // in there; pages faulted in later land wherever the faulting thread's
+  // policy puts them.
+  //
+  struct MappingHints
+  {
+    enum Access { Normal, Sequential, Random };
+
+    Access access    {Normal};
+    bool   willNeed  {false};    // Start reading the whole file in.
+    bool   populate  {false};    // Fault every page in before returning.
+    bool   hugePages {false};    // Transparent huge pages, where supported.
+    int    numaNode  {-1};       // Place the pages on this node.
+
+    static MappingHints sequential() { return {Sequential, true}; }
+    static MappingHints random() { return {Random}; }
+
+    // A read only data set that is used heavily.
+    //
+    static MappingHints hot() { return {Random, false, true, true}; }
+  };
+
   class MappedFile
   {
     AutoFd fd;
 
+    size_t mappedSize{};
+
     std::shared_ptr<uint8_t> mapping;
 
-    size_t mappedSize{};
+    int protection {0};
 
-    uint8_t* mapFile( size_t, int prot, int flags );
+    uint8_t* mapFile( size_t, int prot, int flags, const MappingHints& );
 
   public:
 
@@ -39,8 +73,8 @@ namespace masuma::system
     MappedFile( const MappedFile& ) = default;
     MappedFile& operator=( const MappedFile& ) = default;
 
-    MappedFile( AutoFd, size_t, int prot, int flags );
-    MappedFile( const std::string&, size_t, int prot, int flags );
+    MappedFile( AutoFd, size_t, int prot, int flags, const MappingHints& = {} );
+    MappedFile( const std::string&, size_t, int prot, int flags, const MappingHints& = {} );
 
     virtual ~MappedFile() = default;
 
@@ -56,14 +90,68 @@ namespace masuma::system
 
     iterator end()             { return mapping.get()+mappedSize; }
     const_iterator end() const { return mapping.get()+mappedSize; }
+
+    // madvise() the pages covering [offset,offset+length), clipped to the
+    // mapping.
+    //
+    void advise( size_t offset, size_t length, int advice ) const;
+
+    // Faults in the pages covering [offset,offset+length) so that reading
+    // them doesn't stop for I/O.  Uses MADV_POPULATE_READ/WRITE, or starts
+    // read ahead with MADV_WILLNEED on kernels without them.
+    //
+    void prefault( size_t offset, size_t length ) const;
+
+    // Places the mapping's pages on a NUMA node, moving those already
+    // resident and faulting the rest in there.  Later faults aren't bound.
+    //
+    void bind( int node ) const;
+  };
+
+  // Keeps the pages from a cursor to distance ahead of it faulted in, step
+  // bytes at a time, for a reader moving forward through a mapping:
+  //
+  //   ReadAhead ahead {file};
+  //
+  //   for( size_t offset = 0; offset < file.size(); offset += n )
+  //   {
+  //     ahead( offset );
+  //     ...
+  //
+  class ReadAhead
+  {
+    const MappedFile& file;
+
+    const size_t distance;
+    const size_t step;
+
+    size_t faulted {0};
+
+  public:
+
+    explicit ReadAhead( const MappedFile& file, size_t distance = 16*1024*1024,
+                        size_t step = 4*1024*1024 )
+      : file {file}, distance {distance}, step {step} {}
+
+    void operator()( size_t cursor )
+    {
+      while( faulted < file.size() && faulted < cursor+distance )
+      {
+        const size_t from = std::max( faulted, cursor );
+
+        file.prefault( from, step );
+
+        faulted = from+step;
+      }
+    }
   };
 
   class ReadOnlyMappedFile : public MappedFile
   {
   public:
 
-    ReadOnlyMappedFile( const std::string&, size_t = 0 );
-    ReadOnlyMappedFile( AutoFd, size_t = 0 );
+    ReadOnlyMappedFile( const std::string&, size_t = 0, const MappingHints& = {} );
+    ReadOnlyMappedFile( AutoFd, size_t = 0, const MappingHints& = {} );
   };
 
   class WriteOnlyMappedFile : public MappedFile
@@ -71,8 +159,8 @@ namespace masuma::system
   public:
 
     WriteOnlyMappedFile() = default;
-    WriteOnlyMappedFile( const std::string&, size_t = 0 );
-    WriteOnlyMappedFile( AutoFd, size_t = 0 );
+    WriteOnlyMappedFile( const std::string&, size_t = 0, const MappingHints& = {} );
+    WriteOnlyMappedFile( AutoFd, size_t = 0, const MappingHints& = {} );
   };
 }
 
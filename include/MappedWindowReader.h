@@ -0,0 +1,162 @@
+/******************************* C++ Header File *******************************
+*
+*  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+*
+*  MODULE:      system
+*
+*  DESCRIPTION: Sequential reader mapping a file a window at a time.
+*
+*******************************************************************************/
+
+#pragma once
+
+#include "AutoFd.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace masuma::system
+{
+  // Reads a file of any size through mmap while only mapping windowSize (two
+  // windows with prefetching) at a time.  Once a window is handed out a
+  // helper thread maps the next one and faults it in, and unmaps the one
+  // before, so a sequential reader doesn't wait on either.
+  //
+  // Reading is by window with next(), or a byte at a time through the
+  // iterators, which move between windows as they go.  Only one pass can be
+  // active: next() or begin() invalidates the previous window.
+  //
+  class MappedWindowReader
+  {
+    struct Window
+    {
+      uint8_t* data   {nullptr};
+      size_t   size   {0};
+      uint64_t offset {0};
+    };
+
+    AutoFd fd;
+
+    const uint64_t fileSize;
+    const size_t   windowSize;
+
+    Window   current;
+    uint64_t nextOffset {0};
+
+    // Shared with the helper.
+    //
+    std::mutex              mutex;
+    std::condition_variable changed;
+    std::optional<uint64_t> wanted;       // To be prefetched,
+    std::optional<uint64_t> fetching;     // being prefetched,
+    std::optional<Window>   prefetched;   // and when it has been.
+    std::vector<Window>     released;     // To be unmapped.
+    bool                    stopping {false};
+
+    std::thread helper;
+
+    Window map( uint64_t offset ) const;
+    static void unmap( const Window& );
+
+    void prefetch();
+
+  public:
+
+    MappedWindowReader( const std::string& file, size_t windowSize = 64*1024*1024,
+                        bool prefetch = true );
+
+    MappedWindowReader( AutoFd, size_t windowSize = 64*1024*1024, bool prefetch = true );
+
+    MappedWindowReader( const MappedWindowReader& ) = delete;
+    MappedWindowReader& operator=( const MappedWindowReader& ) = delete;
+
+    ~MappedWindowReader();
+
+    [[nodiscard]] uint64_t size() const { return fileSize; }
+
+    // The next window, empty at the end of the file.
+    //
+    std::span<const uint8_t> next();
+
+    // Starts again from the beginning of the file.
+    //
+    void rewind() { nextOffset = 0; }
+
+    // The file offset of the window last returned by next().
+    //
+    [[nodiscard]] uint64_t offset() const { return current.offset; }
+
+    class const_iterator
+    {
+      MappedWindowReader* reader {nullptr};
+
+      const uint8_t* next {nullptr};
+      const uint8_t* last {nullptr};
+
+      void load()
+      {
+        const std::span<const uint8_t> window {reader->next()};
+
+        if( window.empty() )
+        {
+          reader = nullptr;
+          next = last = nullptr;
+        }
+        else
+        {
+          next = window.data();
+          last = window.data()+window.size();
+        }
+      }
+
+    public:
+
+      using iterator_category = std::input_iterator_tag;
+      using value_type        = uint8_t;
+      using difference_type   = std::ptrdiff_t;
+      using pointer           = const uint8_t*;
+      using reference         = const uint8_t&;
+
+      const_iterator() = default;
+
+      explicit const_iterator( MappedWindowReader* r ) : reader {r}
+      {
+        reader->rewind();
+        load();
+      }
+
+      const uint8_t& operator*() const { return *next; }
+
+      const_iterator& operator++()
+      {
+        if( ++next == last )
+        {
+          load();
+        }
+
+        return *this;
+      }
+
+      void operator++( int ) { ++*this; }
+
+      // Offset in the file, before end().
+      //
+      [[nodiscard]] uint64_t offset() const
+      {
+        return reader->offset()+(next-reader->current.data);
+      }
+
+      bool operator==( const const_iterator& other ) const { return next == other.next; }
+      bool operator!=( const const_iterator& other ) const { return next != other.next; }
+    };
+
+    const_iterator begin() { return const_iterator {this}; }
+    const_iterator end() { return {}; }
+  };
+}
@@ -0,0 +1,105 @@
+/******************************* C++ Header File *******************************
+*
+*  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+*
+*  MODULE:      system
+*
+*  DESCRIPTION: Append only writer through a growing or sliding mapping.
+*
+*******************************************************************************/
+
+#pragma once
+
+#include "AutoFd.h"
+
+#include <cstdint>
+#include <string>
+
+namespace masuma::system
+{
+  // Writes a file of unknown size sequentially through mmap.
+  //
+  // Space is fallocate()d allocationStep at a time ahead of the mapping, so
+  // running out of space is an exception from the writer rather than a
+  // SIGBUS while copying; on filesystems without fallocate the file is
+  // extended sparse.  Either
+  //
+  //   Grow:  the whole file stays mapped, the mapping being extended with
+  //          mremap() windowSize at a time, so data() covers everything
+  //          written, or
+  //
+  //   Slide: only a window of windowSize is mapped, moved forward as it
+  //          fills, so the file can be larger than the address space.
+  //
+  // Write back of each windowSize written is started as it completes and the
+  // one before waited for, so dirty pages stay bounded without the writer
+  // waiting on the one being written.  close() (or destruction) truncates
+  // the file to the length written.
+  //
+  class MappedWriter
+  {
+  public:
+
+    enum Mode { Grow, Slide };
+
+  private:
+
+    AutoFd fd;
+
+    const Mode   mode;
+    const size_t windowSize;
+    const size_t allocationStep;
+
+    uint8_t* window {nullptr};
+    size_t   mapped {0};
+
+    uint64_t windowOffset {0};    // File offset of window[0].
+    uint64_t length       {0};
+    uint64_t allocated    {0};
+    uint64_t flushed      {0};    // Write back started to here,
+    uint64_t written      {0};    // and finished to here.
+
+    bool open {true};
+
+    void allocate( uint64_t end );
+    void map( uint64_t offset, size_t size );
+    void writeBack( uint64_t end );
+
+  public:
+
+    MappedWriter( const std::string& file, Mode = Slide,
+                  size_t windowSize = 64*1024*1024, size_t allocationStep = 1024*1024*1024 );
+
+    // Writes from the start of fd, replacing what was there.
+    //
+    MappedWriter( AutoFd fd, Mode = Slide,
+                  size_t windowSize = 64*1024*1024, size_t allocationStep = 1024*1024*1024 );
+
+    MappedWriter( const MappedWriter& ) = delete;
+    MappedWriter& operator=( const MappedWriter& ) = delete;
+
+    ~MappedWriter();
+
+    // Space for the next n bytes, which commit() adds to the file.  When
+    // sliding n can't exceed windowSize.
+    //
+    uint8_t* reserve( size_t n );
+
+    void commit( size_t n ) { length += n; writeBack( length ); }
+
+    void write( const void*, size_t );
+
+    [[nodiscard]] uint64_t size() const { return length; }
+
+    // Everything written, when growing.  The mapping may move as it grows,
+    // as may any reservation.
+    //
+    [[nodiscard]] const uint8_t* data() const { return window; }
+
+    // Waits for everything written to reach the disk.
+    //
+    void sync();
+
+    void close();
+  };
+}
@@ -214,10 +214,7 @@ namespace masuma
     template <typename ParamType> inline ParamType
     convert( const std::string& s )
     {
-      ParamType param;
-      std::istringstream in(s);
-      in >> param;
-      return param;
+      return fromString<ParamType>( s );
     }
 
     template <> inline std::string
@@ -278,8 +275,7 @@ namespace masuma
       DoubleParameterisedOption( ArgV::iterator&  i )
         : ParameterisedOption<T,O,Type1>( i )
       {
-        std::istringstream in(*++i);
-        in >> param1;
+        param1 = convert<Type1>(*++i);
       }
 
       Option<T>* clone( ArgV::iterator& i )
@@ -29,6 +29,13 @@ namespace masuma::system
     virtual bool processData( uint16_t ) = 0;
     virtual bool processError( uint16_t ) = 0;
 
+    // Milliseconds until the action wants processTimeout() called, or -1
+    // for no deadline.  The Poller waits no longer than the soonest, so an
+    // action can hold work back for a while without blocking the others.
+    //
+    virtual int timeout() const { return -1; }
+    virtual bool processTimeout() { return true; }
+
     enum EventType { Data, Error };
 
     bool process( uint16_t revent, EventType type )
@@ -56,6 +63,38 @@ namespace masuma::system
     Fds     fds;
     Actions actions;
 
+    // The soonest of the Processor's and the actions' timeouts.
+    //
+    int waitTime()
+    {
+      int wait = Processor::timeout();
+
+      for( const auto& action : actions )
+      {
+        const int due = action->timeout();
+
+        if( due >= 0 && (wait < 0 || due < wait) )
+        {
+          wait = due;
+        }
+      }
+
+      return wait;
+    }
+
+    bool due() const
+    {
+      for( const auto& action : actions )
+      {
+        if( action->timeout() == 0 )
+        {
+          return true;
+        }
+      }
+
+      return false;
+    }
+
     bool poll()
     {
       for( unsigned n = 0; n < fds.size(); fds[n++].revents = 0 );
@@ -65,10 +104,15 @@ namespace masuma::system
 
       do
       {
-        found = CheckSys( ::poll, ( &fds[0], fds.size(), Processor::timeout() ) ) > 0;
+        found = CheckSys( ::poll, ( &fds[0], fds.size(), waitTime() ) ) > 0;
 
         if( !found )
         {
+          if( due() )
+          {
+            return true;
+          }
+
           keepWaiting = Processor::timeoutHook();
         }
       }
@@ -117,6 +161,24 @@ namespace masuma::system
         ++action;
       }
 
+      fd     = fds.begin();
+      action = actions.begin();
+
+      while( fd != fds.end() )
+      {
+        if( (*action)->timeout() == 0 )
+        {
+          if( !(*action)->processTimeout() )
+          {
+            fd     = fds.erase( fd );
+            action = actions.erase( action );
+            continue;
+          }
+        }
+        ++fd;
+        ++action;
+      }
+
       return Processor::keepRunning && !fds.empty();
     }
 
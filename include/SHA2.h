@@ -1,60 +1,195 @@
 /******************************* C++ Header File *******************************
 *
-*  Copyright (c) Masuma Ltd 2014-2018.  All rights reserved.
+*  Copyright (c) Masuma Ltd 2014-2026.  All rights reserved.
 *
 *  MODULE:      system
 *
+*  DESCRIPTION: SHA-1 and SHA-2 hashes through the OpenSSL EVP interface.
+*
 *******************************************************************************/
 
 #pragma once
 
-#include <openssl/sha.h>
+#include "Exception.h"
+
+#include <openssl/evp.h>
+#include <sys/uio.h>
 #include <limits.h>
 #include <array>
+#include <memory>
 #include <iostream>
 #include <iomanip>
+#include <sstream>
+#include <string>
 
 namespace masuma::system
 {
-  constexpr size_t sha2Size = 32;
+  struct SHA1Algorithm
+  {
+    static constexpr size_t      size {20};
+    static constexpr const char* name {"SHA1"};
+  };
 
-  using SHA1_Number = std::array<uint8_t,sha2Size>;
+  struct SHA256Algorithm
+  {
+    static constexpr size_t      size {32};
+    static constexpr const char* name {"SHA256"};
+  };
 
-  inline auto
-  sha2( const void* buf, size_t size )
+  struct SHA512Algorithm
+  {
+    static constexpr size_t      size {64};
+    static constexpr const char* name {"SHA512"};
+  };
+
+  // The digest is fetched from the provider once rather than on every
+  // initialisation, which is what the EVP_sha256() style calls cost under
+  // OpenSSL 3.  OpenSSL picks the SHA-NI/AVX2 code at run time.
+  //
+  template <typename Algorithm>
+  const EVP_MD*
+  evpDigest()
   {
-    SHA_CTX   context;
+    static const std::unique_ptr<EVP_MD, void(*)(EVP_MD*)> digest
+    {
+      CheckNull( EVP_MD_fetch, ( nullptr, Algorithm::name, nullptr ) ),
+      EVP_MD_free
+    };
 
-    SHA1_Init( &context );
+    return digest.get();
+  }
 
-    SHA1_Update( &context, buf, size );
+  template <typename Algorithm>
+  struct SHASum
+  {
+    std::array<uint8_t,Algorithm::size> bytes {};
 
-    SHA1_Number result;
+    bool operator==( const SHASum& other ) const { return bytes == other.bytes; }
+    bool operator<( const SHASum& other ) const { return bytes < other.bytes; }
 
-    SHA1_Final( result.data(), &context );
+    operator std::string() const
+    {
+      std::ostringstream os;
 
-    return result;
-  }
+      os << *this;
 
-  class SHA1_56Sum
+      return os.str();
+    }
+
+    friend std::ostream& operator<<( std::ostream& out, const SHASum& sum )
+    {
+      for( auto n : sum.bytes )
+      {
+        out << std::hex << std::setfill('0') << std::setw(2) << (unsigned)n;
+      }
+
+      return out << std::dec << std::setfill(' ');
+    }
+
+    static SHASum hash( const uint8_t* start, size_t size )
+    {
+      SHASum sum;
+
+      CheckCondition( EVP_Digest( start, size, sum.bytes.data(), nullptr,
+                                  evpDigest<Algorithm>(), nullptr ) == 1 );
+
+      return sum;
+    }
+  };
+
+  // The context is allocated once and re-initialised after each sum(), so a
+  // hash object may be kept and reused for any number of digests.
+  //
+  template <typename Algorithm>
+  class SHAHash
   {
-    SHA_CTX context;
+    std::unique_ptr<EVP_MD_CTX, void(*)(EVP_MD_CTX*)> context;
 
   public:
 
-    SHA1_56Sum()
+    using Sum = SHASum<Algorithm>;
+
+    SHAHash()
+      : context {CheckNull( EVP_MD_CTX_new, () ), EVP_MD_CTX_free}
     {
-      SHA1_Init( &context );
+      reset();
     }
 
+    void reset()
+    {
+      CheckCondition( EVP_DigestInit_ex2( context.get(), evpDigest<Algorithm>(),
+                                          nullptr ) == 1 );
+    }
+
+    void update( const void* buf, size_t size )
+    {
+      CheckCondition( EVP_DigestUpdate( context.get(), buf, size ) == 1 );
+    }
+
+    void sum( Sum& result )
+    {
+      CheckCondition( EVP_DigestFinal_ex( context.get(), result.bytes.data(),
+                                          nullptr ) == 1 );
+      reset();
+    }
+
+    // Hash count separate buffers into sums[0..count) with the one context,
+    // for content addressing many small objects without a context per call.
+    //
+    void hash( const iovec* buffers, size_t count, Sum* sums )
+    {
+      for( size_t n = 0; n < count; ++n )
+      {
+        update( buffers[n].iov_base, buffers[n].iov_len );
+        sum( sums[n] );
+      }
+    }
+  };
+
+  using SHA1Sum   = SHASum<SHA1Algorithm>;
+  using SHA256Sum = SHASum<SHA256Algorithm>;
+  using SHA512Sum = SHASum<SHA512Algorithm>;
+
+  using SHA1Hash   = SHAHash<SHA1Algorithm>;
+  using SHA256Hash = SHAHash<SHA256Algorithm>;
+  using SHA512Hash = SHAHash<SHA512Algorithm>;
+
+  constexpr size_t sha1Size = SHA1Algorithm::size;
+
+  using SHA1_Number = std::array<uint8_t,sha1Size>;
+
+  inline auto
+  sha1( const void* buf, size_t size )
+  {
+    return SHA1Sum::hash( static_cast<const uint8_t*>(buf), size ).bytes;
+  }
+
+  // Historical name, this has always been SHA-1.
+  //
+  inline auto
+  sha2( const void* buf, size_t size )
+  {
+    return sha1( buf, size );
+  }
+
+  class SHA1_56Sum
+  {
+    SHA1Hash hash;
+
+  public:
+
     void update( const void* buf, size_t size )
     {
-      SHA1_Update( &context, buf, size );
+      hash.update( buf, size );
     }
 
     void sum( SHA1_Number& result )
     {
-      SHA1_Final( result.data(), &context );
+      SHA1Sum digest;
+
+      hash.sum( digest );
+
+      result = digest.bytes;
     }
 
     friend std::ostream& operator<<( std::ostream& out, const SHA1_Number& sha )
@@ -0,0 +1,136 @@
+/******************************* C++ Header File *******************************
+*
+*  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+*
+*  MODULE:      system
+*
+*  DESCRIPTION: Persistent directory tree snapshot for incremental scans.
+*
+*******************************************************************************/
+
+#pragma once
+
+#include "MappedFile.h"
+#include "Stat.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace masuma::system
+{
+  // The file is a header, the directory records sorted by (device,inode),
+  // the child records (each directory's children contiguous) and a pool of
+  // names.  It is mapped read only and searched in place, so loading costs a
+  // mmap and a pass checking the records' ranges, not parsing the tree.
+  //
+  class ScanSnapshot
+  {
+  public:
+
+    struct Header
+    {
+      char     magic[8];
+      uint32_t version;
+      uint32_t reserved;
+      uint64_t directoryCount;
+      uint64_t childCount;
+      uint64_t nameBytes;
+    };
+
+    struct DirectoryRecord
+    {
+      uint64_t device;
+      uint64_t inode;
+      int64_t  changeTime;
+      int64_t  modifyTime;
+      uint64_t firstChild;
+      uint64_t childCount;
+
+      bool operator<( const DirectoryRecord& other ) const
+      {
+        return device == other.device ? inode < other.inode : device < other.device;
+      }
+    };
+
+    struct ChildRecord
+    {
+      uint64_t inode;
+      int64_t  modifyTime;
+      uint64_t size;
+      uint64_t nameOffset;
+      uint32_t nameLength;
+      FileType type;
+    };
+
+    static constexpr uint32_t version {1};
+
+  private:
+
+    MappedFile mapping;
+
+    const DirectoryRecord* directories {nullptr};
+    const ChildRecord*     childRecords {nullptr};
+    const char*            names {nullptr};
+
+    size_t directoryCount {0};
+
+  public:
+
+    // An empty snapshot.
+    //
+    ScanSnapshot() = default;
+
+    // A missing, truncated, corrupt or foreign file loads as empty, so the
+    // first scan with it reports everything.
+    //
+    explicit ScanSnapshot( const std::string& file );
+
+    [[nodiscard]] size_t size() const { return directoryCount; }
+
+    [[nodiscard]] const DirectoryRecord* find( uint64_t device, uint64_t inode ) const;
+
+    [[nodiscard]] const ChildRecord* begin( const DirectoryRecord& dir ) const
+    {
+      return childRecords+dir.firstChild;
+    }
+
+    [[nodiscard]] const ChildRecord* end( const DirectoryRecord& dir ) const
+    {
+      return childRecords+dir.firstChild+dir.childCount;
+    }
+
+    [[nodiscard]] std::string_view name( const ChildRecord& child ) const
+    {
+      return {names+child.nameOffset, child.nameLength};
+    }
+
+    // Collects a new snapshot during a scan.  Each directory's children are
+    // added with child() straight after its directory().
+    //
+    class Builder
+    {
+      std::vector<DirectoryRecord> directories;
+      std::vector<ChildRecord>     children;
+      std::string                  names;
+
+    public:
+
+      void directory( const Stat& status, bool complete );
+
+      void child( std::string_view name, uint64_t inode, int64_t modifyTime,
+                  uint64_t size, FileType type );
+
+      // Writes to a temporary and renames it over file.
+      //
+      void write( const std::string& file );
+    };
+  };
+
+  inline int64_t
+  nanoseconds( const Stat::TimePoint& time )
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>( time.time_since_epoch() ).count();
+  }
+}
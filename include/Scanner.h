@@ -15,6 +15,9 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
 
 #if !defined _POSIX_PTHREAD_SEMANTICS
  #define _POSIX_PTHREAD_SEMANTICS
@@ -23,6 +26,7 @@
 #include "Exception.h"
 #include "directory.h"
 #include "String.h"
+#include "TaskPool.h"
 
 #include "Stat.h"
 
@@ -40,6 +44,100 @@ namespace masuma
       using Directory = system::PosixDirectory;
     };
 
+    // Reads directories with getdents64 and classifies entries by d_type,
+    // only calling lstat for DT_UNKNOWN or when the Actions declare that they
+    // use the status:
+    //
+    //   static constexpr bool needsStatus = true;
+    //
+    struct GetdentsTraits
+    {
+      static void getStatus( const std::string& filepath, struct stat* sb )
+      {
+        CheckSysM( lstat, (filepath.c_str(), sb), filepath );
+      }
+
+      using Directory = system::GetdentsDirectory;
+
+      static constexpr bool useEntryType {true};
+    };
+
+    // Reads each directory relative to its parent's descriptor and stats
+    // entries with statx() on that descriptor and the bare name, so nothing
+    // walks the full path and the path string is only built when something
+    // asks for entry.name().  Actions may restrict what statx() fetches:
+    //
+    //   static constexpr unsigned statxMask = STATX_TYPE|STATX_SIZE;
+    //
+    struct AtTraits
+    {
+      using Directory = system::AtDirectory;
+
+      static constexpr bool useEntryType {true};
+      static constexpr bool statAt {true};
+    };
+
+    template <typename Actions>
+    constexpr bool actionsNeedStatus = []
+    {
+      if constexpr( requires { Actions::needsStatus; } )
+      {
+        return bool {Actions::needsStatus};
+      }
+      else
+      {
+        return false;
+      }
+    }();
+
+    template <typename Actions>
+    constexpr unsigned actionsStatxMask = []
+    {
+      if constexpr( requires { Actions::statxMask; } )
+      {
+        return unsigned {Actions::statxMask|STATX_TYPE};
+      }
+      else
+      {
+        return actionsNeedStatus<Actions> ? unsigned {STATX_BASIC_STATS} : unsigned {STATX_TYPE};
+      }
+    }();
+
+    template <typename Actions, typename Traits, typename Entry>
+    FileType
+    scanType( Stat& status, const Entry& entry )
+    {
+      if constexpr( requires { Traits::useEntryType; } )
+      {
+        if constexpr( Traits::useEntryType && !actionsNeedStatus<Actions> )
+        {
+          switch( entry.type() )
+          {
+            case DT_UNKNOWN: break;
+            case DT_REG:     return FileType::Regular;
+            case DT_DIR:     return FileType::Directory;
+            case DT_LNK:     return FileType::Link;
+            case DT_FIFO:    return FileType::FifoSpecial;
+            case DT_BLK:     return FileType::BlockSpecial;
+            case DT_CHR:     return FileType::CharSpecial;
+            default:         return FileType::Other;
+          }
+        }
+      }
+
+      if constexpr( requires { Traits::statAt; } )
+      {
+        status.reset( entry.directory().descriptor(), entry.value().d_name,
+                      actionsStatxMask<Actions> );
+      }
+      else
+      {
+        status.reset( entry.name() );
+      }
+
+      return status.fileType();
+    }
+
     template <typename Actions, typename Traits = FilesystemTraits>
     struct Scanner : Actions
     {
@@ -56,19 +154,17 @@ namespace masuma
 
       void operator()( const typename Directory::Entry& entry )
       {
-        const std::string filepath {entry.name()};
-
         try
         {
-          status.reset( filepath );
+          const FileType type {scanType<Actions,Traits>( status, entry )};
 
-          if( status.isRegular() )
+          if( type == FileType::Regular )
           {
             ++files;
 
             Actions::processFile( entry, data );
           }
-          else if( status.isDirectory() )
+          else if( type == FileType::Directory )
           {
             ++directories;
 
@@ -78,7 +174,7 @@ namespace masuma
 
             if( dirResult.first )
             {
-              //std::cout << dir.size() << " " << filepath << std::endl;
+              //std::cout << dir.size() << " " << entry.name() << std::endl;
 
               std::for_each( dir.begin(), dir.end(), Scanner(dirResult.second) );
             }
@@ -94,12 +190,12 @@ namespace masuma
         {
           if( e.errVal() != ELOOP )
           {
-            std::cerr << filepath << ' ' << e.what() << std::endl;
+            std::cerr << entry.name() << ' ' << e.what() << std::endl;
           }
         }
         catch( std::exception& e )
         {
-          std::cerr << filepath << ' ' << e.what() << std::endl;
+          std::cerr << entry.name() << ' ' << e.what() << std::endl;
         }
       }
 
@@ -140,26 +236,291 @@ namespace masuma
     template <typename T, typename TT> unsigned Scanner<T,TT>::files;
     template <typename T, typename TT> unsigned Scanner<T,TT>::directories;
 
+    // Scans with a TaskPool, each directory being a task.  Each task has its
+    // own Actions (and so its own status), but callbacks from different tasks
+    // run concurrently, so anything the Actions share must be thread safe.
+    //
+    // A directory is read and closed by its task and the entries are handed
+    // out in batches, so the callbacks for one large directory are spread
+    // over the pool too, unless Actions declares
+    //
+    //   static constexpr bool serialiseDirectory = true;
+    //
+    // in which case they are made in order from a single task.  As with
+    // Scanner, finishedDirectory() is called once everything below the
+    // directory has been processed.
+    //
+    template <typename Actions, typename Traits = FilesystemTraits>
+    class ParallelScanner
+    {
+      using DataType   = typename Actions::DataType;
+      using Directory  = typename Traits::Directory;
+      using Entry      = typename Directory::Entry;
+      using EntryType  = typename Directory::EntryType;
+      using ReturnType = std::pair<bool,DataType>;
+
+      static constexpr size_t batchSize {256};
+
+      // With AtTraits entries are stat'ed and subdirectories opened through
+      // the directory's descriptor, so it stays open until the last batch
+      // and child directory holding it are done.
+      //
+      static constexpr bool keepOpen = requires { Traits::statAt; };
+
+      static constexpr bool serialiseDirectory = []
+      {
+        if constexpr( requires { Actions::serialiseDirectory; } )
+        {
+          return bool {Actions::serialiseDirectory};
+        }
+        else
+        {
+          return false;
+        }
+      }();
+
+      // A directory being scanned, kept until the last task below it is done.
+      //
+      struct Node
+      {
+        std::shared_ptr<Directory> parent;
+        EntryType                  entry;
+        std::shared_ptr<Node>      up;
+        std::atomic<size_t>        outstanding {1};
+
+        Node( std::shared_ptr<Directory> parent, const EntryType& entry,
+              std::shared_ptr<Node> up )
+          : parent {std::move(parent)}, entry {entry}, up {std::move(up)} {}
+      };
+
+      struct alignas(64) Counts
+      {
+        unsigned files       {0};
+        unsigned directories {0};
+      };
+
+      TaskPool            pool;
+      std::vector<Counts> counts;
+
+      const DataType root;
+
+      unsigned fileCount      {0};
+      unsigned directoryCount {0};
+
+      static void report( const std::string& filepath, const std::exception& e )
+      {
+        const auto* error = dynamic_cast<const system::Exception*>(&e);
+
+        if( !error || error->errVal() != ELOOP )
+        {
+          std::cerr << filepath << ' ' << e.what() << std::endl;
+        }
+      }
+
+      void finished( std::shared_ptr<Node> node )
+      {
+        while( node && --node->outstanding == 0 )
+        {
+          Actions actions;
+
+          const Entry entry {node->parent.get(), &node->entry};
+
+          try
+          {
+            actions.finishedDirectory( entry );
+          }
+          catch( std::exception& e )
+          {
+            report( entry.name(), e );
+          }
+
+          node = std::move(node->up);
+        }
+      }
+
+      void visit( Actions& actions, Counts& count, const Entry& entry,
+                  const DataType& data, const std::shared_ptr<Directory>& dir,
+                  const std::shared_ptr<Node>& node )
+      {
+        try
+        {
+          const FileType type {scanType<Actions,Traits>( actions.status, entry )};
+
+          if( type == FileType::Regular )
+          {
+            ++count.files;
+
+            actions.processFile( entry, data );
+          }
+          else if( type == FileType::Directory )
+          {
+            ++count.directories;
+
+            if( node )
+            {
+              ++node->outstanding;
+            }
+
+            auto child = std::make_shared<Node>( dir, entry.value(), node );
+
+            pool.post( [this,child,data]{ scanDirectory( child, data ); } );
+          }
+          else
+          {
+            actions.processOther( entry, data );
+          }
+        }
+        catch( std::exception& e )
+        {
+          report( entry.name(), e );
+        }
+      }
+
+      void scanBatch( std::shared_ptr<Directory> dir,
+                      std::shared_ptr<std::vector<EntryType>> entries,
+                      size_t first, size_t last, DataType data,
+                      std::shared_ptr<Node> node )
+      {
+        Actions actions;
+
+        Counts& count = counts[pool.worker()];
+
+        for( size_t n = first; n < last; ++n )
+        {
+          visit( actions, count, Entry {dir.get(), &(*entries)[n]}, data, dir, node );
+        }
+
+        finished( std::move(node) );
+      }
+
+      void scanDirectory( std::shared_ptr<Node> node, const DataType& data )
+      {
+        Actions actions;
+
+        const Entry entry {node->parent.get(), &node->entry};
+
+        try
+        {
+          auto dir = std::make_shared<Directory>( entry );
+
+          ReturnType dirResult {actions.processDirectory( entry, *dir, data )};
+
+          if( dirResult.first )
+          {
+            auto entries = std::make_shared<std::vector<EntryType>>();
+
+            for( auto it = dir->begin(); it != dir->end(); ++it )
+            {
+              entries->push_back( (*it).value() );
+            }
+
+            if constexpr( !keepOpen )
+            {
+              dir->close();
+            }
+
+            const size_t step = serialiseDirectory ? entries->size() : batchSize;
+
+            for( size_t first = 0; first < entries->size(); first += step )
+            {
+              const size_t last = std::min( first+step, entries->size() );
+
+              ++node->outstanding;
+
+              pool.post( [=,this,data = dirResult.second]
+              {
+                scanBatch( dir, entries, first, last, data, node );
+              });
+            }
+          }
+        }
+        catch( std::exception& e )
+        {
+          report( entry.name(), e );
+        }
+
+        finished( std::move(node) );
+      }
+
+    public:
+
+      explicit ParallelScanner( const DataType& root,
+                                unsigned threads = std::thread::hardware_concurrency() )
+        : pool {threads}, counts(pool.size()+1), root {root} {}
+
+      void start()
+      {
+        counts.assign( counts.size(), Counts {} );
+
+        std::string dirPath {root};
+
+        if( *dirPath.rbegin() == '/' )
+        {
+          dirPath.erase(dirPath.begin()+(dirPath.size()-1));
+        }
+
+        auto tailHead = system::splitLast( dirPath, '/' );
+
+        if( tailHead.first.empty() )
+        {
+          tailHead.first = "/";
+        }
+
+        auto dir = std::make_shared<Directory>( tailHead.first, nullptr );
+
+        auto target = dir->find( tailHead.second );
+
+        if( target != dir->end() )
+        {
+          auto entries = std::make_shared<std::vector<EntryType>>( 1, (*target).value() );
+
+          if constexpr( !keepOpen )
+          {
+            dir->close();
+          }
+
+          pool.post( [this,dir,entries]{ scanBatch( dir, entries, 0, 1, root, nullptr ); } );
+
+          pool.wait();
+        }
+
+        fileCount      = 0;
+        directoryCount = 1;
+
+        for( const auto& count : counts )
+        {
+          fileCount      += count.files;
+          directoryCount += count.directories;
+        }
+      }
+
+      unsigned files() const { return fileCount; }
+      unsigned directories() const { return directoryCount; }
+    };
+
     // The following code is provided as an example Action class for a scanner.
     // It may be used as a base class.
     //
-    struct BasicActions
+    template <typename Directory>
+    struct DirectoryActions
     {
       system::Stat status;
 
       using DataType   =  std::string;
       using ReturnType = std::pair<bool,DataType>;
 
-      virtual void processFile(  const PosixDirectory::Entry&, const DataType& ) = 0;
-      virtual void processOther( const PosixDirectory::Entry&, const DataType& ) = 0;
+      virtual void processFile(  const typename Directory::Entry&, const DataType& ) = 0;
+      virtual void processOther( const typename Directory::Entry&, const DataType& ) = 0;
 
-      virtual ReturnType processDirectory( const PosixDirectory::Entry&,
-                                           PosixDirectory&,
+      virtual ReturnType processDirectory( const typename Directory::Entry&,
+                                           Directory&,
                                            const DataType& ) = 0;
 
-      virtual void finishedDirectory( const PosixDirectory::Entry& ) {}
+      virtual void finishedDirectory( const typename Directory::Entry& ) {}
     };
 
+    using BasicActions = DirectoryActions<PosixDirectory>;
+
     struct ExampleActions : BasicActions
     {
       void processFile( const PosixDirectory::Entry& entry, const DataType& )
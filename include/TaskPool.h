@@ -0,0 +1,84 @@
+/******************************* C++ Header File *******************************
+*
+*  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+*
+*  MODULE:      system
+*
+*  DESCRIPTION: Work stealing thread pool.
+*
+*******************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace masuma::system
+{
+  // Each worker has its own deque.  Tasks posted from a worker go on the back
+  // of its deque and it takes work from the back, so a recursive job runs
+  // depth first and keeps the queues short; idle workers steal from the front
+  // of the others, which is where the larger pieces of work are.
+  //
+  // wait() blocks until every task, including those posted by tasks, has
+  // run.  The first exception thrown by a task is rethrown from wait().
+  //
+  class TaskPool
+  {
+  public:
+
+    using Task = std::function<void()>;
+
+  private:
+
+    struct Queue
+    {
+      std::mutex       mutex;
+      std::deque<Task> tasks;
+    };
+
+    std::deque<Queue>        queues;
+    std::vector<std::thread> threads;
+
+    std::mutex              mutex;
+    std::condition_variable idle;
+    std::condition_variable done;
+
+    std::atomic<size_t>   queued  {0};
+    std::atomic<size_t>   pending {0};
+    std::atomic<unsigned> next    {0};
+
+    bool               stopping {false};
+    std::exception_ptr error;
+
+    bool take( unsigned self, Task& );
+    void run( unsigned self );
+
+  public:
+
+    explicit TaskPool( unsigned threads = std::thread::hardware_concurrency() );
+
+    TaskPool( const TaskPool& ) = delete;
+    TaskPool& operator=( const TaskPool& ) = delete;
+
+    ~TaskPool();
+
+    void post( Task );
+
+    void wait();
+
+    [[nodiscard]] unsigned size() const { return threads.size(); }
+
+    // Index of the calling worker in this pool, or size() if the caller is
+    // not one of its workers.
+    //
+    [[nodiscard]] unsigned worker() const;
+  };
+}
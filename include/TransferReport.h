@@ -13,6 +13,9 @@
 #include "Streamable.h"
 #include "Log.h"
 
+#include <array>
+#include <atomic>
+
 namespace masuma::system
 {
   class TransferBytes : public Streamable
@@ -55,39 +58,135 @@ namespace masuma::system
     explicit ElapsedTime( double time ) : time(time) {}
   };
 
+  // A view of a transfer in progress that may be taken from any thread.
+  // Stage times are in seconds.  The reader waits on the source and for free
+  // buffers, the writer on the destination and for full buffers, so whichever
+  // side is starved points at the other as the bottleneck.
+  //
+  struct TransferSnapshot : Streamable
+  {
+    uint64_t bytes         {0};
+    double   elapsed       {0};
+    double   averageRate   {0};
+    double   instantRate   {0};
+    double   ewmaRate      {0};
+    double   readWait      {0};
+    double   writeWait     {0};
+    double   readerStarved {0};
+    double   writerStarved {0};
+    uint64_t readerStalls  {0};
+    uint64_t writerStalls  {0};
+
+    [[nodiscard]] const char* bottleneck() const;
+
+    void json( std::ostream& ) const;
+
+  private:
+
+    void stream( std::ostream& ) const override;
+  };
+
   class TransferReport
   {
+  public:
+
+    enum Stage
+    {
+      Read,
+      Write,
+      ReaderStarved,
+      WriterStarved,
+      stageCount
+    };
+
+  private:
+
     Stopwatch stopwatch;
 
-    uint64_t bytesSent  {0};
+    std::atomic<uint64_t> bytesSent {0};
     uint64_t lastReport {0};
 
+    int64_t  lastSample      {0};
+    uint64_t lastSampleBytes {0};
+
+    std::atomic<double> instantRate {0};
+    std::atomic<double> ewmaRate    {0};
+
+    std::array<std::atomic<int64_t>,stageCount>  stageTime {};
+    std::array<std::atomic<uint64_t>,stageCount> stalls {};
+
     Log::Level level;
 
+    void sample();
+
   public:
 
     static uint64_t threshold;
 
+    // Waits longer than stallThreshold (ns) count as stalls, rates are
+    // sampled at most every sampleInterval (ns) and smoothed by ewmaWeight.
+    //
+    static int64_t stallThreshold;
+    static int64_t sampleInterval;
+    static double  ewmaWeight;
+
+    // Times its own lifetime against a stage; does nothing without a report.
+    //
+    class StageTimer
+    {
+      TransferReport* const report;
+      const Stage           stage;
+      const int64_t         start;
+
+    public:
+
+      StageTimer( TransferReport* report, Stage stage )
+        : report {report}, stage {stage},
+          start {report ? timeNow(CLOCK_MONOTONIC) : 0} {}
+
+      StageTimer( const StageTimer& ) = delete;
+      StageTimer& operator=( const StageTimer& ) = delete;
+
+      ~StageTimer()
+      {
+        if( report ) report->addStageTime( stage, timeNow(CLOCK_MONOTONIC) - start );
+      }
+    };
+
     TransferReport( Log::Level );
 
-    void start() { stopwatch.start(); }
+    void start();
 
     double elapsed() const { return stopwatch.elapsed(); }
 
     uint64_t operator()( uint64_t n )
     {
-      bytesSent += n;
+      const uint64_t sent = bytesSent.fetch_add( n, std::memory_order_relaxed ) + n;
 
-      if( bytesSent - lastReport > threshold )
+      if( sent - lastReport > threshold )
       {
         report();
 
-        lastReport = bytesSent;
+        lastReport = sent;
       }
 
+      sample();
+
       return n;
     }
 
+    void addStageTime( Stage stage, int64_t ns )
+    {
+      stageTime[stage].fetch_add( ns, std::memory_order_relaxed );
+
+      if( ns > stallThreshold )
+      {
+        stalls[stage].fetch_add( 1, std::memory_order_relaxed );
+      }
+    }
+
+    [[nodiscard]] TransferSnapshot snapshot() const;
+
     uint64_t report();
     uint64_t report( uint64_t& );
   };
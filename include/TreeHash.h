@@ -0,0 +1,217 @@
+/******************************* C++ Header File *******************************
+*
+*  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+*
+*  MODULE:      system
+*
+*  DESCRIPTION: Parallel Merkle tree hash of large files.
+*
+*******************************************************************************/
+
+#pragma once
+
+#include "MappedFile.h"
+#include "AutoFd.h"
+
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#include <unistd.h>
+
+namespace masuma::system
+{
+  // Splits the input into fixed size chunks, hashes them in parallel and
+  // combines the leaf digests pairwise into a root.  Leaves are hashed as
+  // 0x00||chunk and interior nodes as 0x01||left||right, an odd node being
+  // carried up unchanged, so the root depends on the chunk size as well as
+  // the data.  Hash is any of the update()/sum() hashes (MD5Hash, XXH3Hash..).
+  //
+  // The leaf digests are kept so a receiver can compare chunk by chunk.
+  //
+  template <typename Hash>
+  class TreeHash
+  {
+  public:
+
+    using Sum = typename Hash::Sum;
+
+    static constexpr size_t defaultChunkSize {4*1024*1024};
+
+  private:
+
+    const size_t   chunkSize;
+    const unsigned threads;
+
+    std::vector<Sum> leafSums;
+
+    static Sum node( uint8_t tag, const void* lhs, size_t lhsSize,
+                     const void* rhs = nullptr, size_t rhsSize = 0 )
+    {
+      Hash hash;
+
+      hash.update( &tag, 1 );
+      hash.update( lhs, lhsSize );
+
+      if( rhs )
+      {
+        hash.update( rhs, rhsSize );
+      }
+
+      Sum sum;
+
+      hash.sum( sum );
+
+      return sum;
+    }
+
+    static void readChunk( int fd, uint8_t* buffer, size_t size, off_t offset )
+    {
+      while( size )
+      {
+        const ssize_t n = CheckSys( ::pread, ( fd, buffer, size, offset ) );
+
+        CheckConditionM( n > 0, "TreeHash: unexpected end of file" );
+
+        buffer += n;
+        offset += n;
+        size   -= n;
+      }
+    }
+
+    // Reader is called as reader( offset, size, scratch ) and returns a
+    // pointer to the chunk, using the per-thread scratch vector if it needs
+    // somewhere to put it.
+    //
+    template <typename Reader>
+    void hashLeaves( size_t size, Reader reader )
+    {
+      const size_t count = size ? (size + chunkSize - 1)/chunkSize : 1;
+
+      leafSums.assign( count, Sum {} );
+
+      std::atomic<size_t> next {0};
+      std::exception_ptr  error;
+      std::atomic_flag    failed;
+
+      auto worker = [&]
+      {
+        std::vector<uint8_t> scratch;
+
+        try
+        {
+          for( size_t n; (n = next++) < count; )
+          {
+            const size_t offset = n*chunkSize;
+            const size_t length = std::min( chunkSize, size - offset );
+
+            leafSums[n] = node( 0, reader( offset, length, scratch ), length );
+          }
+        }
+        catch( ... )
+        {
+          next = count;
+
+          if( !failed.test_and_set() )
+          {
+            error = std::current_exception();
+          }
+        }
+      };
+
+      std::vector<std::thread> workers;
+
+      const unsigned extra = std::min<size_t>( threads, count ) - 1;
+
+      for( unsigned n = 0; n < extra; ++n )
+      {
+        workers.emplace_back( worker );
+      }
+
+      worker();
+
+      for( auto& thread : workers )
+      {
+        thread.join();
+      }
+
+      if( error )
+      {
+        std::rethrow_exception( error );
+      }
+    }
+
+  public:
+
+    explicit TreeHash( size_t chunkSize = defaultChunkSize,
+                       unsigned threads = std::thread::hardware_concurrency() )
+      : chunkSize {chunkSize}, threads {std::max( threads, 1u )}
+    {
+      CheckCondition( chunkSize > 0 );
+    }
+
+    Sum hash( const uint8_t* data, size_t size )
+    {
+      hashLeaves( size, [data]( size_t offset, size_t, std::vector<uint8_t>& )
+      {
+        return data+offset;
+      });
+
+      return root();
+    }
+
+    Sum hash( const MappedFile& file )
+    {
+      return hash( file.begin(), file.size() );
+    }
+
+    Sum hash( const AutoFd& fd, size_t size )
+    {
+      const int descriptor = fd.get();
+
+      hashLeaves( size, [descriptor]( size_t offset, size_t length,
+                                      std::vector<uint8_t>& scratch )
+      {
+        scratch.resize( length );
+
+        readChunk( descriptor, scratch.data(), length, offset );
+
+        return scratch.data();
+      });
+
+      return root();
+    }
+
+    size_t chunk() const { return chunkSize; }
+
+    const std::vector<Sum>& leaves() const { return leafSums; }
+
+    Sum root() const { return combine( leafSums ); }
+
+    static Sum combine( std::vector<Sum> level )
+    {
+      CheckCondition( !level.empty() );
+
+      while( level.size() > 1 )
+      {
+        size_t out = 0;
+
+        for( size_t n = 0; n+1 < level.size(); n += 2 )
+        {
+          level[out++] = node( 1, &level[n], sizeof(Sum), &level[n+1], sizeof(Sum) );
+        }
+
+        if( level.size() & 1 )
+        {
+          level[out++] = level.back();
+        }
+
+        level.resize( out );
+      }
+
+      return level.front();
+    }
+  };
+}
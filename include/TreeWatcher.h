@@ -0,0 +1,496 @@
+/******************************* C++ Header File *******************************
+*
+*  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+*
+*  MODULE:      system
+*
+*  DESCRIPTION: inotify change feed for a directory tree.
+*
+*******************************************************************************/
+
+#pragma once
+
+#include "IncrementalScanner.h"
+#include "Poller.h"
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+#include <sys/inotify.h>
+
+namespace masuma::system
+{
+  // Watches every directory below root with inotify and reports changes to
+  // the same Actions a Scanner uses.  Register with a Poller after start():
+  //
+  //   auto* watcher = new TreeWatcher<MyActions> {root, snapshot};
+  //   watcher->start();
+  //   poller << watcher;
+  //
+  // start() is an IncrementalScanner pass from the snapshot, reporting what
+  // changed since it was written and putting a watch on each directory as
+  // processDirectory() accepts it.
+  //
+  // Events arriving together are collected until the feed has been quiet for
+  // settle, or latency has passed since the first, then delivered once per
+  // name: the entry is stat'ed and reported with processFile()/processOther(),
+  // a new directory is scanned (and watched) in full, and a name that has
+  // gone is reported with processRemoved() if Actions has it.  The wait is
+  // the Poller's timeout rather than the watcher's own, so other actions on
+  // the Poller carry on meanwhile.  Removed entries are reported as what
+  // they were when last seen: inotify only says whether a name was a
+  // directory, so the types of entries reported with processOther() are
+  // remembered.
+  //
+  // If the kernel queue overflows the events are lost, so another
+  // IncrementalScanner pass is made; only directories whose ctime has changed
+  // are read, though changes already delivered since the snapshot was written
+  // are reported again.
+  //
+  template <typename Actions, typename Traits = FilesystemTraits>
+  class TreeWatcher : public PollerAction
+  {
+    using DataType   = typename Actions::DataType;
+    using Directory  = typename Traits::Directory;
+    using Entry      = typename Directory::Entry;
+    using EntryType  = typename Directory::EntryType;
+    using ReturnType = std::pair<bool,DataType>;
+    using Clock      = std::chrono::steady_clock;
+
+    static constexpr uint32_t watchMask {IN_CREATE|IN_DELETE|IN_MOVED_FROM|IN_MOVED_TO|
+                                         IN_CLOSE_WRITE|IN_ATTRIB|IN_ONLYDIR|
+                                         IN_DONT_FOLLOW|IN_EXCL_UNLINK};
+
+    // Adds a watch for each directory the wrapped Actions descend into, and
+    // notes the type of each entry that isn't a regular file.
+    //
+    struct WatchingActions : Actions
+    {
+      TreeWatcher* watcher {nullptr};
+
+      ReturnType processDirectory( const Entry& entry, Directory& dir, const DataType& data )
+      {
+        ReturnType result {Actions::processDirectory( entry, dir, data )};
+
+        if( result.first && watcher )
+        {
+          watcher->watch( entry.name(), result.second );
+        }
+
+        return result;
+      }
+
+      void processFile( const Entry& entry, const DataType& data )
+      {
+        if( watcher && !watcher->others.empty() )
+        {
+          watcher->others.erase( entry.name() );
+        }
+
+        Actions::processFile( entry, data );
+      }
+
+      void processOther( const Entry& entry, const DataType& data )
+      {
+        if( watcher )
+        {
+          Stat status;
+
+          watcher->others.insert_or_assign( entry.name(), scanType<Actions,Traits>( status, entry ) );
+        }
+
+        Actions::processOther( entry, data );
+      }
+    };
+
+    struct Watched
+    {
+      std::string path;
+      DataType    data;
+    };
+
+    // The first event for a name says whether it existed before the burst.
+    //
+    struct Events
+    {
+      uint32_t first {0};
+      uint32_t all   {0};
+    };
+
+    AutoFd inotify;
+
+    const DataType    root;
+    const std::string snapshotFile;
+
+    const std::chrono::milliseconds settle;
+    const std::chrono::milliseconds latency;
+
+    WatchingActions actions;
+
+    std::unordered_map<int,Watched>              watches;
+    std::map<int,std::map<std::string,Events>> pending;
+
+    std::unordered_map<std::string,FileType> others;
+
+    bool overflowed {false};
+
+    // When the burst being collected began and was last added to.
+    //
+    Clock::time_point first;
+    Clock::time_point last;
+
+    alignas(inotify_event) char buffer[64*1024];
+
+    static void report( const std::string& filepath, const std::exception& e )
+    {
+      std::cerr << filepath << ' ' << e.what() << std::endl;
+    }
+
+    void watch( const std::string& path, const DataType& data )
+    {
+      const int wd = inotify_add_watch( inotify.get(), path.c_str(), watchMask );
+
+      if( wd < 0 )
+      {
+        std::cerr << path << " inotify_add_watch: " << strerror( errno ) << std::endl;
+        return;
+      }
+
+      watches.insert_or_assign( wd, Watched {path, data} );
+    }
+
+    static bool below( const std::string& name, const std::string& path )
+    {
+      return name.size() > path.size() && name.starts_with( path ) && name[path.size()] == '/';
+    }
+
+    // A directory moved away keeps its watches under the old paths.
+    //
+    void unwatch( const std::string& path )
+    {
+      for( auto it = watches.begin(); it != watches.end(); )
+      {
+        const std::string& watched {it->second.path};
+
+        if( watched == path || below( watched, path ) )
+        {
+          inotify_rm_watch( inotify.get(), it->first );
+          it = watches.erase( it );
+        }
+        else
+        {
+          ++it;
+        }
+      }
+
+      std::erase_if( others, [&path]( const auto& other ) { return below( other.first, path ); } );
+    }
+
+    // What a name that has gone was.
+    //
+    FileType removedType( const std::string& path, uint32_t mask )
+    {
+      if( mask & IN_ISDIR )
+      {
+        return FileType::Directory;
+      }
+
+      const auto found = others.find( path );
+
+      if( found == others.end() )
+      {
+        return FileType::Regular;
+      }
+
+      const FileType type {found->second};
+
+      others.erase( found );
+
+      return type;
+    }
+
+    void drain()
+    {
+      while( true )
+      {
+        const ssize_t n = read( inotify.get(), buffer, sizeof buffer );
+
+        if( n < 0 && errno == EAGAIN )
+        {
+          return;
+        }
+
+        CheckConditionM( n > 0, "inotify read" );
+
+        for( const char* next = buffer; next < buffer+n; )
+        {
+          const auto* event = reinterpret_cast<const inotify_event*>(next);
+
+          next += sizeof(inotify_event)+event->len;
+
+          if( event->mask & IN_Q_OVERFLOW )
+          {
+            overflowed = true;
+          }
+          else if( event->mask & IN_IGNORED )
+          {
+            watches.erase( event->wd );
+            pending.erase( event->wd );
+          }
+          else if( event->len )
+          {
+            Events& events {pending[event->wd][event->name]};
+
+            if( !events.first )
+            {
+              events.first = event->mask;
+            }
+
+            events.all |= event->mask;
+          }
+        }
+      }
+    }
+
+    void scanTree( const Entry& entry, const DataType& data )
+    {
+      Directory dir {entry};
+
+      ReturnType dirResult {actions.processDirectory( entry, dir, data )};
+
+      if( dirResult.first )
+      {
+        for( auto it = dir.begin(); it != dir.end(); ++it )
+        {
+          const Entry child {*it};
+
+          try
+          {
+            const FileType type {scanType<Actions,Traits>( actions.status, child )};
+
+            if( type == FileType::Regular )
+            {
+              actions.processFile( child, dirResult.second );
+            }
+            else if( type == FileType::Directory )
+            {
+              scanTree( child, dirResult.second );
+            }
+            else
+            {
+              actions.processOther( child, dirResult.second );
+            }
+          }
+          catch( std::exception& e )
+          {
+            report( child.name(), e );
+          }
+        }
+      }
+
+      actions.finishedDirectory( entry );
+    }
+
+    void deliver( const Watched& watched, const std::map<std::string,Events>& names )
+    {
+      const Directory dir {watched.path, nullptr};
+
+      for( const auto& [name, events] : names )
+      {
+        const uint32_t mask {events.all};
+
+        const std::string path {watched.path+'/'+name};
+
+        try
+        {
+          struct stat sb;
+
+          if( lstat( path.c_str(), &sb ) != 0 )
+          {
+            CheckConditionM( errno == ENOENT || errno == ENOTDIR, path );
+
+            // Created and removed within the burst is nothing.
+            //
+            if( !(events.first & (IN_CREATE|IN_MOVED_TO)) )
+            {
+              if( mask & IN_ISDIR )
+              {
+                unwatch( path );
+              }
+
+              const FileType type {removedType( path, mask )};
+
+              if constexpr( requires { actions.processRemoved( path, FileType::Missing, watched.data ); } )
+              {
+                actions.processRemoved( path, type, watched.data );
+              }
+            }
+            else
+            {
+              others.erase( path );
+            }
+
+            continue;
+          }
+
+          actions.status = Stat {sb};
+
+          EntryType value {};
+
+          value.d_ino  = sb.st_ino;
+          value.d_type = IFTODT( sb.st_mode );
+
+          name.copy( value.d_name, sizeof(value.d_name)-1 );
+
+          const Entry entry {&dir, &value};
+
+          const FileType type {actions.status.fileType()};
+
+          if( type == FileType::Directory )
+          {
+            others.erase( path );
+
+            if( mask & (IN_CREATE|IN_MOVED_TO) )
+            {
+              if( mask & IN_MOVED_FROM )
+              {
+                unwatch( path );
+              }
+
+              scanTree( entry, watched.data );
+            }
+          }
+          else if( type == FileType::Regular )
+          {
+            actions.processFile( entry, watched.data );
+          }
+          else
+          {
+            actions.processOther( entry, watched.data );
+          }
+        }
+        catch( std::exception& e )
+        {
+          report( path, e );
+        }
+      }
+    }
+
+    void flush()
+    {
+      if( overflowed )
+      {
+        overflowed = false;
+        pending.clear();
+
+        rescan();
+        return;
+      }
+
+      auto batch = std::move(pending);
+
+      pending.clear();
+
+      for( const auto& [wd, names] : batch )
+      {
+        const auto found = watches.find( wd );
+
+        if( found == watches.end() )
+        {
+          continue;
+        }
+
+        const Watched watched {found->second};
+
+        try
+        {
+          deliver( watched, names );
+        }
+        catch( std::exception& e )
+        {
+          report( watched.path, e );
+        }
+      }
+    }
+
+    void rescan()
+    {
+      IncrementalScanner<WatchingActions,Traits> scanner {actions, root, snapshotFile};
+
+      scanner.start();
+    }
+
+  public:
+
+    TreeWatcher( const DataType& root, const std::string& snapshotFile,
+                 std::chrono::milliseconds settle = std::chrono::milliseconds {50},
+                 std::chrono::milliseconds latency = std::chrono::milliseconds {500} )
+      : PollerAction {CheckSys( inotify_init1, (IN_NONBLOCK|IN_CLOEXEC) ), POLLIN},
+        inotify {PollerAction::fd},
+        root {root},
+        snapshotFile {snapshotFile},
+        settle {settle},
+        latency {latency}
+    {
+      actions.watcher = this;
+    }
+
+    void start()
+    {
+      rescan();
+    }
+
+    // The Actions events are reported to.
+    //
+    Actions& handler() { return actions; }
+
+    [[nodiscard]] size_t size() const { return watches.size(); }
+
+    bool processData( uint16_t ) override
+    {
+      const bool collecting {!pending.empty() || overflowed};
+
+      drain();
+
+      last = Clock::now();
+
+      if( !collecting )
+      {
+        first = last;
+      }
+
+      return true;
+    }
+
+    // Until the feed has been quiet for settle or latency has passed since
+    // the burst began.
+    //
+    int timeout() const override
+    {
+      if( pending.empty() && !overflowed )
+      {
+        return -1;
+      }
+
+      const auto deadline = std::min( last+settle, first+latency );
+
+      const auto wait = std::chrono::ceil<std::chrono::milliseconds>( deadline-Clock::now() );
+
+      return std::max<int>( wait.count(), 0 );
+    }
+
+    bool processTimeout() override
+    {
+      flush();
+
+      return true;
+    }
+
+    bool processError( uint16_t ) override
+    {
+      return false;
+    }
+  };
+}
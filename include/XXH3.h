@@ -0,0 +1,161 @@
+/******************************* C++ Header File *******************************
+*
+*  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+*
+*  MODULE:      system
+*
+*  DESCRIPTION: XXH3 64 and 128 bit non-cryptographic hashes.
+*
+*******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+namespace masuma::system
+{
+  // Streaming XXH3 state with the default secret and a zero seed, so results
+  // match XXH3_64bits()/XXH3_128bits() from the reference library.  The
+  // stripe accumulation uses AVX2 where the CPU has it.
+  //
+  class XXH3State
+  {
+    alignas(64) uint64_t acc[8];
+    alignas(64) uint8_t  buffer[256];
+
+    size_t   buffered      {0};
+    size_t   stripesSoFar  {0};
+    uint64_t totalLength   {0};
+
+    void finalAccumulators( uint64_t* ) const;
+
+  public:
+
+    XXH3State();
+
+    void update( const void*, size_t );
+
+    [[nodiscard]] uint64_t digest64() const;
+
+    void digest128( uint64_t& low, uint64_t& high ) const;
+  };
+
+  uint64_t xxh3_64( const void*, size_t );
+  void     xxh3_128( const void*, size_t, uint64_t& low, uint64_t& high );
+
+  struct XXH3Sum
+  {
+    uint64_t value {0};
+
+    bool operator==( const XXH3Sum& other ) const { return value == other.value; }
+    bool operator<( const XXH3Sum& other ) const { return value < other.value; }
+
+    operator std::string() const
+    {
+      std::ostringstream os;
+
+      os << *this;
+
+      return os.str();
+    }
+
+    friend std::ostream& operator<<( std::ostream& out, const XXH3Sum& sum )
+    {
+      return out << std::hex << std::setfill('0') << std::setw(16) << sum.value
+                 << std::dec << std::setfill(' ');
+    }
+
+    static XXH3Sum hash( const uint8_t* start, size_t size )
+    {
+      return {xxh3_64( start, size )};
+    }
+  };
+
+  // bits[0] is the low half, bits[1] the high.  Streams in the canonical
+  // (high half first) form.
+  //
+  struct XXH3_128Sum
+  {
+    uint64_t bits[2] {};
+
+    bool operator==( const XXH3_128Sum& other ) const
+    {
+      return (bits[0] == other.bits[0] && bits[1] == other.bits[1]);
+    }
+
+    bool operator<( const XXH3_128Sum& other ) const
+    {
+      return (bits[1] == other.bits[1] ?
+              bits[0] < other.bits[0] :
+              bits[1] < other.bits[1]);
+    }
+
+    operator std::string() const
+    {
+      std::ostringstream os;
+
+      os << *this;
+
+      return os.str();
+    }
+
+    friend std::ostream& operator<<( std::ostream& out, const XXH3_128Sum& sum )
+    {
+      return out << std::hex << std::setfill('0')
+                 << std::setw(16) << sum.bits[1] << std::setw(16) << sum.bits[0]
+                 << std::dec << std::setfill(' ');
+    }
+
+    static XXH3_128Sum hash( const uint8_t* start, size_t size )
+    {
+      XXH3_128Sum sum;
+
+      xxh3_128( start, size, sum.bits[0], sum.bits[1] );
+
+      return sum;
+    }
+  };
+
+  class XXH3Hash
+  {
+    XXH3State state;
+
+  public:
+
+    using Sum = XXH3Sum;
+
+    void update( const void* buf, size_t size )
+    {
+      state.update( buf, size );
+    }
+
+    void sum( XXH3Sum& result )
+    {
+      result.value = state.digest64();
+    }
+  };
+
+  class XXH3_128Hash
+  {
+    XXH3State state;
+
+  public:
+
+    using Sum = XXH3_128Sum;
+
+    void update( const void* buf, size_t size )
+    {
+      state.update( buf, size );
+    }
+
+    void sum( XXH3_128Sum& result )
+    {
+      state.digest128( result.bits[0], result.bits[1] );
+    }
+  };
+}
@@ -11,15 +11,23 @@
 #ifndef _utils_directory_h_
 #define _utils_directory_h_
 
+#include "Exception.h"
+
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <string.h>
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <algorithm>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <unordered_set>
 
 namespace masuma
 {
@@ -49,6 +57,11 @@ namespace masuma
       {
         return entry->d_name;
       }
+
+      static unsigned char type( const Entry_t* entry )
+      {
+        return entry->d_type;
+      }
       
       static void rewind( Dir_t dir )
       {
@@ -61,12 +74,119 @@ namespace masuma
       }
     };
     
+    // Reads entries in bulk with getdents64 rather than one readdir() at a
+    // time through libc's smaller buffer.  Entries point into the buffer,
+    // which has a dirent64's worth of slack at the end so that an entry may be
+    // copied out as a whole dirent64.
+    //
+    struct GetdentsDirectoryTraits
+    {
+      struct Stream
+      {
+        static constexpr size_t bufferSize {64*1024};
+
+        int    fd;
+        size_t offset {0};
+        size_t end    {0};
+
+        alignas(dirent64) char buffer[bufferSize+sizeof(dirent64)];
+
+        explicit Stream( int fd ) : fd {fd} {}
+      };
+
+      using Dir_t = Stream*;
+      using Entry_t = dirent64;
+
+      static Dir_t open( std::string path )
+      {
+        return new Stream {CheckSysM( ::open, (path.c_str(), O_RDONLY|O_DIRECTORY|O_CLOEXEC), path )};
+      }
+
+      static void close( Dir_t dir )
+      {
+        ::close( dir->fd );
+        delete dir;
+      }
+
+      static Entry_t* read( Dir_t dir )
+      {
+        if( dir->offset >= dir->end )
+        {
+          dir->offset = 0;
+          dir->end    = CheckSys( getdents64, (dir->fd, dir->buffer, Stream::bufferSize) );
+
+          if( dir->end == 0 )
+          {
+            return nullptr;
+          }
+        }
+
+        auto* entry = reinterpret_cast<Entry_t*>(dir->buffer+dir->offset);
+
+        dir->offset += entry->d_reclen;
+
+        return entry;
+      }
+
+      static std::string name( const Entry_t* entry )
+      {
+        return entry->d_name;
+      }
+
+      static unsigned char type( const Entry_t* entry )
+      {
+        return entry->d_type;
+      }
+
+      static void rewind( Dir_t dir )
+      {
+        CheckSys( lseek, (dir->fd, 0, SEEK_SET) );
+
+        dir->offset = dir->end = 0;
+      }
+
+      static auto stat( std::string path, struct stat* st )
+      {
+        return ::stat( path.c_str(), st );
+      }
+    };
+
+    // As GetdentsDirectoryTraits, but subdirectories are opened relative to
+    // their parent's descriptor, so the kernel resolves one name rather than
+    // the whole path, and the descriptor is there for fstatat()/statx() of
+    // the entries.
+    //
+    struct AtDirectoryTraits : GetdentsDirectoryTraits
+    {
+      static Dir_t openAt( Dir_t parent, const char* name )
+      {
+        return new Stream {CheckSysM( ::openat, (parent->fd, name, O_RDONLY|O_DIRECTORY|O_CLOEXEC|O_NOFOLLOW), name )};
+      }
+
+      static int descriptor( Dir_t dir )
+      {
+        return dir->fd;
+      }
+    };
+
+    // Reads the whole directory into an arena when it is opened, with an open
+    // addressing index on the names, for large directories that are searched:
+    // find() and isNewFile() are O(1), size() is free, and iterating doesn't
+    // consume the stream, so iterators stay valid.
+    //
+    template <typename Base>
+    struct MaterialisedTraits : Base
+    {
+      static constexpr bool materialise {true};
+    };
+
     template<typename Traits>
     class Directory
     {
       typedef std::vector<std::string> vector;
 
       typename Traits::Dir_t dir;
+      bool isOpen {true};
       
       char buf[1024];
       bool accessHasChanged {false};
@@ -74,8 +194,101 @@ namespace masuma
       Directory( const Directory& );
       Directory& operator=( const Directory& );
 
+      static constexpr bool materialised = []
+      {
+        if constexpr( requires { Traits::materialise; } )
+        {
+          return bool {Traits::materialise};
+        }
+        else
+        {
+          return false;
+        }
+      }();
+
+      // Materialised entries are copied in directory order (d_reclen bytes
+      // each, so as compact as the kernel's records) with a whole Entry_t of
+      // slack at the end so the last may be copied out.  Index slots hold
+      // entry number+1, 0 being empty.
+      //
+      std::vector<char>     arena;
+      std::vector<uint32_t> offsets;
+      std::vector<uint32_t> slots;
+
+      mutable std::mutex                      newFilesMutex;
+      mutable std::unordered_set<std::string> newFileIndex;
+      mutable size_t                          newFilesIndexed {0};
+
+      const typename Traits::Entry_t* entryAt( size_t n ) const
+      {
+        return reinterpret_cast<const typename Traits::Entry_t*>(arena.data()+offsets[n]);
+      }
+
+      static size_t hash( std::string_view name )
+      {
+        return std::hash<std::string_view> {}( name );
+      }
+
+      void materialise()
+      {
+        while( const auto* ent = Traits::read( dir ) )
+        {
+          const std::string_view entryName {ent->d_name};
+
+          if( entryName == "." || entryName == ".." )
+          {
+            continue;
+          }
+
+          const auto* record = reinterpret_cast<const char*>(ent);
+
+          offsets.push_back( arena.size() );
+          arena.insert( arena.end(), record, record+ent->d_reclen );
+        }
+
+        arena.resize( arena.size()+sizeof(typename Traits::Entry_t) );
+
+        size_t capacity {16};
+
+        while( capacity < offsets.size()*2 )
+        {
+          capacity *= 2;
+        }
+
+        slots.assign( capacity, 0 );
+
+        for( uint32_t n = 0; n < offsets.size(); ++n )
+        {
+          size_t slot = hash( entryAt( n )->d_name ) & (capacity-1);
+
+          while( slots[slot] )
+          {
+            slot = (slot+1) & (capacity-1);
+          }
+
+          slots[slot] = n+1;
+        }
+      }
+
+      size_t lookup( std::string_view name ) const
+      {
+        const size_t mask = slots.size()-1;
+
+        for( size_t slot = hash( name ) & mask; slots[slot]; slot = (slot+1) & mask )
+        {
+          if( name == entryAt( slots[slot]-1 )->d_name )
+          {
+            return slots[slot]-1;
+          }
+        }
+
+        return offsets.size();
+      }
+
     public:
 
+      using EntryType = typename Traits::Entry_t;
+
       const std::string name;
 
       vector newFiles;
@@ -97,6 +310,13 @@ namespace masuma
 
         std::string entryName() const { return Traits::name(ent); }
 
+        const EntryType& value() const { return *ent; }
+
+        // The d_type from the directory, DT_UNKNOWN if the filesystem
+        // doesn't provide it.
+        //
+        unsigned char type() const { return Traits::type(ent); }
+
         const auto& directory() const { return *dir; }
 
         auto isNewFile() const { return dir->isNewFile( entryName() ); }
@@ -125,24 +345,32 @@ namespace masuma
 
         const Directory* const dir      {nullptr};
         const typename Traits::Entry_t* currentEntry {nullptr};
+        size_t position {0};
 
         void getNext()
         {
-          do
+          if constexpr( materialised )
+          {
+            currentEntry = position < dir->offsets.size() ? dir->entryAt( position++ ) : nullptr;
+          }
+          else
           {
-            currentEntry = Traits::read(dir->dir);
+            do
+            {
+              currentEntry = Traits::read(dir->dir);
+            }
+            while( currentEntry &&
+                   (Traits::name(currentEntry) == "." ||
+                    Traits::name(currentEntry) == "..") );
           }
-          while( currentEntry &&
-                 (Traits::name(currentEntry) == "." ||
-                  Traits::name(currentEntry) == "..") );
         }
         
       public:
 
         IteratorBase() = default;
 
-        IteratorBase( const Directory* d )
-          : dir {d}
+        IteratorBase( const Directory* d, size_t position = 0 )
+          : dir {d}, position {position}
         {
           getNext();
         }
@@ -167,7 +395,7 @@ namespace masuma
       {
         iterator() = default;
 
-        iterator( const Directory* d ) : IteratorBase {d} {}
+        iterator( const Directory* d, size_t position = 0 ) : IteratorBase {d, position} {}
 
         Entry operator*() const { return {this->dir, this->currentEntry}; }
       };
@@ -176,9 +404,9 @@ namespace masuma
       {
         const_iterator() = default;
 
-        const_iterator( const Directory* d ) : IteratorBase {d} {}
+        const_iterator( const Directory* d, size_t position = 0 ) : IteratorBase {d, position} {}
 
-        const Entry operator*() const { return {dir, this->currentEntry}; }
+        const Entry operator*() const { return {this->dir, this->currentEntry}; }
       };
 
       struct NameIterator : public iterator
@@ -190,37 +418,106 @@ namespace masuma
         std::string operator*() const{ return iterator::operator*().entryName(); }
       };
 
+    private:
+
+      static typename Traits::Dir_t openEntry( const Entry& entry )
+      {
+        if constexpr( requires { Traits::openAt( entry.directory().dir, "" ); } )
+        {
+          return Traits::openAt( entry.directory().dir, entry.value().d_name );
+        }
+        else
+        {
+          return Traits::open( entry.name() );
+        }
+      }
+
+    public:
+
       Directory( const std::string& path, const Directory* )
         : dir {Traits::open( path )},
           name {path}
       {
+        if constexpr( materialised )
+        {
+          materialise();
+        }
       }
 
       explicit Directory( const Entry& entry )
-        : Directory {entry.name(),nullptr} {}
+        : dir {openEntry( entry )},
+          name {entry.name()}
+      {
+        if constexpr( materialised )
+        {
+          materialise();
+        }
+      }
 
-      ~Directory() { Traits::close( dir ); }
+      ~Directory() { close(); }
+
+      // Releases the handle, leaving the name and newFiles for any entries
+      // copied out of the directory.
+      //
+      void close()
+      {
+        if( isOpen )
+        {
+          Traits::close( dir );
+          isOpen = false;
+        }
+      }
 
       void rewind() { Traits::rewind( dir ); }
 
       bool isNewFile( const std::string& path ) const
       {
-        return std::find(newFiles.begin(), newFiles.end(), path) != newFiles.end();
+        if constexpr( materialised )
+        {
+          std::lock_guard<std::mutex> lock {newFilesMutex};
+
+          if( newFiles.size() < newFilesIndexed )
+          {
+            newFileIndex.clear();
+            newFilesIndexed = 0;
+          }
+
+          newFileIndex.insert( newFiles.begin()+newFilesIndexed, newFiles.end() );
+          newFilesIndexed = newFiles.size();
+
+          return newFileIndex.count( path ) != 0;
+        }
+        else
+        {
+          return std::find(newFiles.begin(), newFiles.end(), path) != newFiles.end();
+        }
       }
 
       operator std::string() const { return name; }
 
+      int descriptor() const requires requires { Traits::descriptor( dir ); }
+      {
+        return Traits::descriptor( dir );
+      }
+
       void hasChanged() { accessHasChanged = true; }
 
       bool hasAccessChanged() const { return accessHasChanged; }
 
-      // Invalidates any iterators!
+      // Invalidates any iterators, unless materialised!
       //
       size_t size()
       {
-        auto sz = std::distance(begin(), end());
-        rewind();
-        return sz;
+        if constexpr( materialised )
+        {
+          return offsets.size();
+        }
+        else
+        {
+          auto sz = std::distance(begin(), end());
+          rewind();
+          return sz;
+        }
       }
 
       iterator begin() { return this; }
@@ -244,16 +541,37 @@ namespace masuma
 
       iterator find( const std::string& entry )
       {
-        return std::find_if( begin(), end(), EntryByName(entry) );
+        if constexpr( materialised )
+        {
+          const size_t n = lookup( entry );
+
+          return n < offsets.size() ? iterator {this, n} : end();
+        }
+        else
+        {
+          return std::find_if( begin(), end(), EntryByName(entry) );
+        }
       }
 
       const_iterator find( const std::string& entry ) const
       {
-        return std::find_if( begin(), end(), EntryByName(entry) );
+        if constexpr( materialised )
+        {
+          const size_t n = lookup( entry );
+
+          return n < offsets.size() ? const_iterator {this, n} : end();
+        }
+        else
+        {
+          return std::find_if( begin(), end(), EntryByName(entry) );
+        }
       }
     };
     
     using PosixDirectory = Directory<PosixDirectoryTraits>;
+    using GetdentsDirectory = Directory<GetdentsDirectoryTraits>;
+    using AtDirectory = Directory<AtDirectoryTraits>;
+    using MaterialisedDirectory = Directory<MaterialisedTraits<GetdentsDirectoryTraits>>;
   }
 }
 
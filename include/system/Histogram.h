@@ -0,0 +1,182 @@
+/******************************* C++ Header File *******************************
+ *
+ *  Copyright (c) Masuma Ltd 2026.  All rights reserved.
+ *
+ *  MODULE:      utilities
+ *
+ *  DESCRIPTION: Log-linear latency histogram.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "Time.h"
+
+#include <atomic>
+#include <array>
+#include <bit>
+#include <deque>
+#include <mutex>
+#include <limits>
+#include <iosfwd>
+
+namespace masuma::system
+{
+  // A fixed size, HdrHistogram style histogram.  Each power of two range of
+  // values is split into subBucketHalf linear buckets, so any recorded value
+  // is reported to within 1/64 of its true value.  Values are normally
+  // nanoseconds.
+  //
+  // Recording is lock free.  record() assumes a single writer (use one
+  // Histogram per thread and merge them on read); recordShared() may be used
+  // by many threads at a slightly higher cost.
+  //
+  class Histogram
+  {
+  public:
+
+    static constexpr unsigned subBucketBits  {7};
+    static constexpr uint64_t subBucketCount {1u << subBucketBits};
+    static constexpr uint64_t subBucketHalf  {subBucketCount/2};
+    static constexpr size_t   bucketCount    {(64-subBucketBits)*subBucketHalf + subBucketCount};
+
+    static constexpr size_t indexOf( uint64_t value )
+    {
+      if( value < subBucketCount ) return value;
+
+      const unsigned magnitude = 63 - std::countl_zero(value) - (subBucketBits-1);
+
+      return magnitude*subBucketHalf + (value >> magnitude);
+    }
+
+    static constexpr uint64_t lowestEquivalent( size_t index )
+    {
+      if( index < subBucketCount ) return index;
+
+      const unsigned magnitude = index/subBucketHalf - 1;
+
+      return (index - magnitude*subBucketHalf) << magnitude;
+    }
+
+    static constexpr uint64_t highestEquivalent( size_t index )
+    {
+      if( index < subBucketCount ) return index;
+
+      const unsigned magnitude = index/subBucketHalf - 1;
+
+      return ((index - magnitude*subBucketHalf + 1) << magnitude) - 1;
+    }
+
+  private:
+
+    using Counter = std::atomic<uint64_t>;
+
+    std::array<Counter,bucketCount> counts {};
+
+    Counter total   {0};
+    Counter sum     {0};
+    Counter minimum {std::numeric_limits<uint64_t>::max()};
+    Counter maximum {0};
+
+    static void bump( Counter& c, uint64_t n = 1 )
+    {
+      c.store( c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed );
+    }
+
+    static uint64_t clamp( int64_t value ) { return value < 0 ? 0 : value; }
+
+  public:
+
+    Histogram() = default;
+    Histogram( const Histogram& other ) { *this += other; }
+    Histogram& operator=( const Histogram& ) = delete;
+
+    void record( int64_t value )
+    {
+      const uint64_t v = clamp( value );
+
+      bump( counts[indexOf(v)] );
+      bump( total );
+      bump( sum, v );
+
+      if( v < minimum.load(std::memory_order_relaxed) )
+      {
+        minimum.store( v, std::memory_order_relaxed );
+      }
+
+      if( v > maximum.load(std::memory_order_relaxed) )
+      {
+        maximum.store( v, std::memory_order_relaxed );
+      }
+    }
+
+    void record( const Stopwatch& stopwatch ) { record( stopwatch.elapsedTicks() ); }
+
+    void recordShared( int64_t value );
+
+    // Only safe when no thread is recording.
+    //
+    void reset();
+
+    Histogram& operator+=( const Histogram& );
+
+    [[nodiscard]] uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint64_t min() const;
+    [[nodiscard]] uint64_t max() const { return maximum.load(std::memory_order_relaxed); }
+    [[nodiscard]] double   mean() const;
+
+    [[nodiscard]] uint64_t countAt( size_t index ) const
+    {
+      return counts[index].load(std::memory_order_relaxed);
+    }
+
+    // percentile is 0-100, so p999 is valueAtPercentile(99.9).
+    //
+    [[nodiscard]] uint64_t valueAtPercentile( double percentile ) const;
+
+    // One line summary, values divided by scale (1000 for microseconds).
+    //
+    void print( std::ostream&, double scale = 1.0 ) const;
+
+    // lower,upper,count for each non empty bucket.
+    //
+    void csv( std::ostream& ) const;
+
+    friend std::ostream& operator<<( std::ostream&, const Histogram& );
+  };
+
+  // Hands out one Histogram per recording thread and merges them on demand.
+  // Histograms remain valid for the life of the group.
+  //
+  class HistogramGroup
+  {
+    mutable std::mutex    guard;
+    std::deque<Histogram> histograms;
+
+  public:
+
+    Histogram& add();
+
+    [[nodiscard]] Histogram merged() const;
+
+    void reset();
+  };
+
+  // Records the lifetime of the object in a histogram.
+  //
+  template <clockid_t CLOCK = CLOCK_MONOTONIC>
+  class ScopedLatency
+  {
+    Histogram&    histogram;
+    const int64_t start {timeNow(CLOCK)};
+
+  public:
+
+    explicit ScopedLatency( Histogram& histogram ) : histogram {histogram} {}
+
+    ScopedLatency( const ScopedLatency& ) = delete;
+    ScopedLatency& operator=( const ScopedLatency& ) = delete;
+
+    ~ScopedLatency() { histogram.record( timeNow(CLOCK) - start ); }
+  };
+}
@@ -74,6 +74,13 @@ namespace masuma::system
 
     void reset( const std::string& file );
 
+    // Relative to an open directory, without following a final symlink.
+    // The statx form only asks for the fields in mask (STATX_TYPE etc.),
+    // others may be zero.
+    //
+    void reset( int dirfd, const char* name );
+    void reset( int dirfd, const char* name, unsigned mask );
+
     [[nodiscard]] FileType fileType() const;
 
     [[nodiscard]] size_t size() const { return info.st_size; }
@@ -83,7 +90,7 @@ namespace masuma::system
     [[nodiscard]] auto modifyTime() const
     {
       const auto secs {info.st_mtim.tv_sec};
-      const auto nsecs {secs*1'000'000'000 + info.st_ctim.tv_nsec};
+      const auto nsecs {secs*1'000'000'000 + info.st_mtim.tv_nsec};
       std::chrono::nanoseconds ns {nsecs};
       return TimePoint {ns};
     }
@@ -11,7 +11,13 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <optional>
+#include <type_traits>
 #include <vector>
 #include <sstream>
 #include <cstring>
@@ -65,6 +71,7 @@ namespace masuma::system
   template <> inline size_t sizeOf<char>(char) { return 1; }
   template <> inline size_t sizeOf<const char*>(const char* s) {return strlen(s);}
   template <> inline size_t sizeOf<std::string>(std::string s) {return s.size();}
+  template <> inline size_t sizeOf<std::string_view>(std::string_view s) {return s.size();}
 
   inline void
   split( const std::string& in, size_t pos, std::string& lhs, std::string& rhs,
@@ -119,6 +126,89 @@ namespace masuma::system
     split( in, in.find(delim), lhs, rhs, sizeOf(delim) );
   }
 
+  // Lazily splits in on delim as repeated split() calls would: the first
+  // token is always produced and further ones while anything remains, so
+  // "a,,b," gives "a", "" and "b".  The tokens are views into in.
+  //
+  template <typename Delim>
+  class SplitView
+  {
+    std::string_view in;
+    Delim            delim;
+
+  public:
+
+    class iterator
+    {
+      std::string_view rest;
+      std::string_view token;
+      const Delim*     delim {nullptr};
+      bool             more {false};
+      bool             done {true};
+
+      void advance()
+      {
+        if( !more )
+        {
+          done = true;
+          return;
+        }
+
+        const size_t pos = rest.find( *delim );
+
+        token = rest.substr( 0, pos );
+
+        if( pos == std::string_view::npos )
+        {
+          rest = {};
+        }
+        else
+        {
+          rest.remove_prefix( pos+sizeOf( *delim ) );
+        }
+
+        more = !rest.empty();
+      }
+
+    public:
+
+      using iterator_category = std::forward_iterator_tag;
+      using value_type        = std::string_view;
+      using difference_type   = std::ptrdiff_t;
+      using pointer           = const std::string_view*;
+      using reference         = std::string_view;
+
+      iterator() = default;
+
+      iterator( std::string_view in, const Delim* delim )
+        : rest {in}, delim {delim}, more {true}, done {false}
+      {
+        advance();
+      }
+
+      std::string_view operator*() const { return token; }
+
+      iterator& operator++() { advance(); return *this; }
+      iterator operator++( int ) { auto was = *this; advance(); return was; }
+
+      // Only meaningful against end().
+      //
+      bool operator==( const iterator& other ) const { return done == other.done; }
+      bool operator!=( const iterator& other ) const { return done != other.done; }
+    };
+
+    SplitView( std::string_view in, Delim delim ) : in {in}, delim {delim} {}
+
+    iterator begin() const { return {in, &delim}; }
+    iterator end() const { return {}; }
+  };
+
+  template <typename Delim> SplitView<Delim>
+  splitView( std::string_view in, Delim delim )
+  {
+    return {in, delim};
+  }
+
   struct Tokens : Strings
   {
     Tokens() : Strings() {}
@@ -126,49 +216,69 @@ namespace masuma::system
     template <typename Delim>
     Tokens( const std::string& in, Delim delim )
     {
-      std::string rest(in);
-      std::string token;
-
-      do
+      for( const auto token : splitView( in, delim ) )
       {
-        split( rest, delim, token, rest );
-        push_back(token);
-
-      } while( !rest.empty() );
+        emplace_back( token );
+      }
     }
   };
 
   inline Tokens
   tokenise( const std::string& in, char delim )
   {
-    std::string rest(in);
-    std::string token;
-    Tokens result;
+    return {in, delim};
+  }
 
-    do
-    {
-      split( rest, delim, token, rest );
-      result.push_back(token);
+  // Tokens as views into the one copy of the input it owns.
+  //
+  class ViewTokens
+  {
+    std::string                            text;
+    std::vector<std::pair<size_t,size_t>> bounds;
 
-    } while( !rest.empty() );
+  public:
 
-    return result;
-  }
+    ViewTokens() = default;
 
-  inline void
-  removeSpace( std::string& line )
-  {
-    for( std::string::iterator c = line.begin(); c !=line.end(); )
+    template <typename Delim>
+    ViewTokens( std::string in, Delim delim )
+      : text {std::move(in)}
     {
-      if( std::isspace( *c ) )
+      for( const auto token : splitView( text, delim ) )
       {
-        line.erase( c );
+        bounds.emplace_back( token.data()-text.data(), token.size() );
       }
-      else
+    }
+
+    [[nodiscard]] size_t size() const { return bounds.size(); }
+    [[nodiscard]] bool empty() const { return bounds.empty(); }
+
+    std::string_view operator[]( size_t n ) const
+    {
+      return std::string_view {text}.substr( bounds[n].first, bounds[n].second );
+    }
+
+    Strings strings() const
+    {
+      Strings result;
+
+      result.reserve( size() );
+
+      for( size_t n = 0; n < size(); ++n )
       {
-        ++c;
+        result.emplace_back( (*this)[n] );
       }
+
+      return result;
     }
+  };
+
+  inline void
+  removeSpace( std::string& line )
+  {
+    line.erase( std::remove_if( line.begin(), line.end(),
+                                []( unsigned char c ) { return std::isspace( c ); } ),
+                line.end() );
   }
 
   inline std::string
@@ -192,32 +302,36 @@ namespace masuma::system
     }
   }
 
-  inline std::string
-  trim( const std::string& s)
+  inline std::string_view
+  trimView( std::string_view s, std::string_view toTrim = " " )
   {
-    std::string::size_type first = s.find_first_not_of(' ');
+    const size_t first = s.find_first_not_of( toTrim );
 
-    if(first == std::string::npos)
-      return "";
-    std::string::size_type last = s.find_last_not_of(' ');
-    if(last != std::string::npos)
-      return s.substr(first, last + 1 - first);
-    else
-      return s.substr(first);
+    if( first == std::string_view::npos )
+    {
+      return {};
+    }
+
+    return s.substr( first, s.find_last_not_of( toTrim )+1-first );
+  }
+
+  inline std::string
+  trim( const std::string& s )
+  {
+    return std::string {trimView( s )};
   }
 
   inline std::string
   trim( const std::string& s, const char* toTrim )
   {
-    std::string::size_type first = s.find_first_not_of(toTrim);
+    return std::string {trimView( s, toTrim )};
+  }
 
-    if(first == std::string::npos)
-      return "";
-    std::string::size_type last = s.find_last_not_of(toTrim);
-    if(last != std::string::npos)
-      return s.substr(first, last + 1 - first);
-    else
-      return s.substr(first);
+  inline void
+  trimInPlace( std::string& s, std::string_view toTrim = " " )
+  {
+    s.erase( s.find_last_not_of( toTrim )+1 );
+    s.erase( 0, s.find_first_not_of( toTrim ) );
   }
 
   inline bool
@@ -303,16 +417,70 @@ namespace masuma::system
     return result;
   }
 
+  // Numbers other than bool and the character types are converted with
+  // from_chars/to_chars, without a stream, allocation or locale.  Anything
+  // else goes through a stream as before.
+  //
+  template <typename T>
+  concept FastNumber = std::is_arithmetic_v<T> &&
+                       !std::is_same_v<T,bool> &&
+                       !std::is_same_v<T,char> &&
+                       !std::is_same_v<T,signed char> &&
+                       !std::is_same_v<T,unsigned char> &&
+                       !std::is_same_v<T,wchar_t> &&
+                       !std::is_same_v<T,char8_t> &&
+                       !std::is_same_v<T,char16_t> &&
+                       !std::is_same_v<T,char32_t>;
+
+  // Accepts what a stream would, leading space and a '+' included, and
+  // trailing space, but not anything else after the number.
+  //
+  template <FastNumber T> std::optional<T>
+  tryFromString( std::string_view s )
+  {
+    s = trimView( s, " \t\n\r\f\v" );
+
+    if( s.size() > 1 && s[0] == '+' && s[1] != '-' )
+    {
+      s.remove_prefix( 1 );
+    }
+
+    T value {};
+
+    const auto [end, error] = std::from_chars( s.data(), s.data()+s.size(), value );
+
+    if( error != std::errc {} || end != s.data()+s.size() )
+    {
+      return std::nullopt;
+    }
+
+    return value;
+  }
+
   template <typename T> T
   fromString( const std::string& s )
   {
-    std::istringstream in(s);
+    if constexpr( FastNumber<T> )
+    {
+      const std::optional<T> value {tryFromString<T>( s )};
+
+      if( !value )
+      {
+        Throw( EINVAL, "Bad number \""+s+'"' );
+      }
 
-    T tmp;
+      return *value;
+    }
+    else
+    {
+      std::istringstream in(s);
 
-    in >> tmp;
+      T tmp;
 
-    return tmp;
+      in >> tmp;
+
+      return tmp;
+    }
   }
 
   template <> inline std::string
@@ -321,9 +489,33 @@ namespace masuma::system
     return s;
   }
 
+  // Floating point is formatted as a default stream would, %g with six
+  // digits.
+  //
   template <typename T> std::string
   toString( const T& t )
   {
+    if constexpr( FastNumber<T> )
+    {
+      char buffer[64];
+
+      std::to_chars_result result;
+
+      if constexpr( std::is_floating_point_v<T> )
+      {
+        result = std::to_chars( buffer, buffer+sizeof buffer, t, std::chars_format::general, 6 );
+      }
+      else
+      {
+        result = std::to_chars( buffer, buffer+sizeof buffer, t );
+      }
+
+      if( result.ec == std::errc {} )
+      {
+        return {buffer, result.ptr};
+      }
+    }
+
     std::ostringstream out;
 
     out << t;
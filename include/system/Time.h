@@ -140,9 +140,14 @@ namespace masuma
 
       void start() { startTime = timeNow(clock); }
 
+      [[nodiscard]] int64_t elapsedTicks() const
+      {
+        return timeNow(clock) - startTime;
+      }
+
       [[nodiscard]] double elapsed() const
       {
-        return timeInSeconds( timeNow(clock) - startTime );
+        return timeInSeconds( elapsedTicks() );
       }
     };
   }